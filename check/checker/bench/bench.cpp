@@ -0,0 +1,480 @@
+/**
+ * @file bench.cpp
+ * @brief Benchmarks of the hot paths of the solution checker (see "make bench")
+ *
+ * Each benchmark is run once to warm up and then timed a number of times; the median
+ * and the 10% and 90% percentiles of the timings are reported. If a baseline file is
+ * given, the timings are compared with the ones stored there, and the run fails if a
+ * benchmark got significantly slower: its median grew by more than the threshold and
+ * even its fast runs (10% percentile) are slower than the slow runs of the baseline
+ * (90% percentile), so that the noise of a busy machine is not taken for a regression.
+ * Timings depend on the machine, so the baseline has to be taken on the machine the
+ * benchmarks are run on: it is stored with a key of the host and its CPU, and not compared
+ * with on another host. A missing baseline is written from the timings of the run.
+ */
+
+#include "model.h"
+#include "mpsinput.h"
+#include "gmputils.h"
+#include "rowkernel.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/* default number of timed runs of each benchmark */
+#define BENCH_REPEATS    7
+/* default relative slowdown of a median that fails the run */
+#define BENCH_THRESHOLD  0.25
+/* slowdowns below this many seconds are noise */
+#define BENCH_MINDIFF    0.002
+/* numbers parsed or multiplied in one run of the arithmetic benchmarks */
+#define BENCH_NUMBERS    100000
+/* nonzeros and columns of the matrix of the row activity kernel benchmarks */
+#define BENCH_NONZEROS   2000000
+#define BENCH_COLUMNS    100000
+
+/* timings of a benchmark */
+struct BenchResult
+{
+   std::string name;
+   double median;
+   double p10;
+   double p90;
+};
+
+/* value at fraction @param p of the sorted @param samples (nearest rank) */
+static double percentile(const std::vector<double>& samples, double p)
+{
+   int rank = (int)ceil(p * samples.size());
+   return samples[std::max(rank - 1, 0)];
+}
+
+/* time @param func, once to warm up and then @param repeats times */
+static BenchResult runBench(const std::string& name, int repeats, const std::function<void()>& func)
+{
+   typedef std::chrono::steady_clock Clock;
+   func();
+   std::vector<double> samples;
+   for( int r = 0; r < repeats; ++r )
+   {
+      Clock::time_point start = Clock::now();
+      func();
+      samples.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+   }
+   std::sort(samples.begin(), samples.end());
+
+   BenchResult result;
+   result.name = name;
+   result.median = percentile(samples, 0.5);
+   result.p10 = percentile(samples, 0.1);
+   result.p90 = percentile(samples, 0.9);
+   return result;
+}
+
+/* deterministic pseudo-random numbers (64 bit LCG), so that every run sees the same input */
+static uint64_t nextRandom(uint64_t& state)
+{
+   state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+   return state >> 33;
+}
+
+/* numbers as found in MPS and solution files: integers, decimals, exponents and long mantissas */
+static void makeNumbers(std::vector<std::string>& numbers)
+{
+   uint64_t state = 42;
+   char buf[64];
+   for( int i = 0; i < BENCH_NUMBERS; ++i )
+   {
+      uint64_t r = nextRandom(state);
+      switch( i % 5 )
+      {
+      case 0:
+         snprintf(buf, sizeof(buf), "%d", (int)(r % 2000) - 1000);
+         break;
+      case 1:
+         snprintf(buf, sizeof(buf), "%.6f", (double)(r % 1000000) / 1000.0);
+         break;
+      case 2:
+         snprintf(buf, sizeof(buf), "%.15g", (double)r / 7.0);
+         break;
+      case 3:
+         snprintf(buf, sizeof(buf), "%.10e", (double)(r % 100000) * 1e-9);
+         break;
+      default:
+         snprintf(buf, sizeof(buf), "-%llu.%llu", (unsigned long long)r, (unsigned long long)nextRandom(state));
+         break;
+      }
+      numbers.push_back(buf);
+   }
+}
+
+/* matrix in CSR form with rows of 1 to 64 nonzeros, and values of its columns */
+struct BenchMatrix
+{
+   std::vector<int> rowBeg;
+   std::vector<int> rowInd;
+   std::vector<double> rowVal;
+   std::vector<double> x;
+};
+
+static void makeMatrix(BenchMatrix& matrix)
+{
+   uint64_t state = 4711;
+   matrix.rowBeg.push_back(0);
+   while( (int)matrix.rowInd.size() < BENCH_NONZEROS )
+   {
+      int len = 1 + nextRandom(state) % 64;
+      for( int k = 0; k < len; ++k )
+      {
+         matrix.rowInd.push_back(nextRandom(state) % BENCH_COLUMNS);
+         matrix.rowVal.push_back((double)((int)(nextRandom(state) % 2001) - 1000) / 8.0);
+      }
+      matrix.rowBeg.push_back(matrix.rowInd.size());
+   }
+   for( int j = 0; j < BENCH_COLUMNS; ++j )
+      matrix.x.push_back((double)(nextRandom(state) % 1000) / 10.0);
+}
+
+/* activities of all rows of @param matrix with @param kernel */
+static double allRowActivities(const BenchMatrix& matrix, RowActivityKernel kernel)
+{
+   double sum = 0.0;
+   for( unsigned int i = 0; i + 1 < matrix.rowBeg.size(); ++i )
+   {
+      int beg = matrix.rowBeg[i];
+      double posact;
+      double negact;
+      kernel(&matrix.rowVal[beg], &matrix.rowInd[beg], matrix.x.data(), matrix.rowBeg[i + 1] - beg, posact, negact);
+      sum += posact - negact;
+   }
+   return sum;
+}
+
+/* MPS files of @param dir, in name order */
+static void collectInstances(const char* dir, std::vector<std::string>& files)
+{
+   DIR* d = opendir(dir);
+   if( d == NULL )
+   {
+      printf("cannot open directory <%s>\n", dir);
+      return;
+   }
+   std::vector<std::string> names;
+   struct dirent* entry;
+   while( (entry = readdir(d)) != NULL )
+   {
+      const char* name = entry->d_name;
+      size_t len = strlen(name);
+      if( (len > 4 && !strcmp(name + len - 4, ".mps")) || (len > 7 && !strcmp(name + len - 7, ".mps.gz")) )
+         names.push_back(name);
+   }
+   closedir(d);
+   std::sort(names.begin(), names.end());
+   for( unsigned int i = 0; i < names.size(); ++i )
+      files.push_back(std::string(dir) + "/" + names[i]);
+}
+
+/* name of an instance for the benchmark names: file name without directory and extension */
+static std::string instanceName(const std::string& path)
+{
+   size_t slash = path.rfind('/');
+   std::string name = (slash == std::string::npos ? path : path.substr(slash + 1));
+   return name.substr(0, name.find('.'));
+}
+
+/* write a solution of @param model to @param filename: every variable at the bound closest
+ * to zero, and every third one at one where its bounds allow it */
+static bool writeSolution(const Model* model, const char* filename)
+{
+   FILE* fp = fopen(filename, "w");
+   if( fp == NULL )
+      return false;
+   Rational one(1);
+   for( unsigned int j = 0; j < model->numVars(); ++j )
+   {
+      const Var* var = model->getVar(j);
+      Rational value;
+      if( var->lb.isPositive() )
+         value = var->lb;
+      else if( var->ub.isNegative() )
+         value = var->ub;
+      if( j % 3 == 0 && !(var->lb > one) && !(var->ub < one) )
+         value = one;
+      if( !value.isZero() )
+         fprintf(fp, "%s %.15g\n", var->name, value.toDouble());
+   }
+   fclose(fp);
+   return true;
+}
+
+/* key of the machine timings are taken on: host name, CPU model and number of CPUs */
+static std::string hostKey()
+{
+   char hostname[256] = "";
+   gethostname(hostname, sizeof(hostname) - 1);
+   std::string cpu = "unknown";
+   FILE* fp = fopen("/proc/cpuinfo", "r");
+   if( fp != NULL )
+   {
+      char line[512];
+      while( fgets(line, sizeof(line), fp) != NULL )
+      {
+         const char* colon = strchr(line, ':');
+         if( strncmp(line, "model name", 10) == 0 && colon != NULL )
+         {
+            cpu = colon + 1;
+            cpu.erase(0, cpu.find_first_not_of(" \t"));
+            cpu.erase(cpu.find_last_not_of(" \t\n") + 1);
+            break;
+         }
+      }
+      fclose(fp);
+   }
+   /* spaces would end the key when it is read back */
+   std::string key = std::string(hostname) + "/" + cpu + "/" + std::to_string(sysconf(_SC_NPROCESSORS_ONLN));
+   for( unsigned int i = 0; i < key.size(); ++i )
+   {
+      if( isspace((unsigned char)key[i]) )
+         key[i] = '_';
+   }
+   key.erase(std::unique(key.begin(), key.end(), [](char a, char b) { return a == '_' && b == '_'; }), key.end());
+   return key;
+}
+
+/* read the timings of a baseline file, and the key of the machine they were taken on (empty if not stored) */
+static bool readBaseline(const char* filename, std::map<std::string, BenchResult>& baseline, std::string& host)
+{
+   FILE* fp = fopen(filename, "r");
+   if( fp == NULL )
+      return false;
+   char name[256];
+   char line[512];
+   BenchResult result;
+   host.clear();
+   while( fgets(line, sizeof(line), fp) != NULL )
+   {
+      if( strncmp(line, "# host ", 7) == 0 && sscanf(line + 7, "%255s", name) == 1 )
+         host = name;
+      if( line[0] == '#' )
+         continue;
+      if( sscanf(line, "%255s %lf %lf %lf", name, &result.median, &result.p10, &result.p90) == 4 )
+      {
+         result.name = name;
+         baseline[name] = result;
+      }
+   }
+   fclose(fp);
+   return true;
+}
+
+/* store the timings of @param results as baseline */
+static bool writeBaseline(const char* filename, const std::vector<BenchResult>& results)
+{
+   FILE* fp = fopen(filename, "w");
+   if( fp == NULL )
+      return false;
+   fprintf(fp, "# solchecker benchmark baseline (written by make bench-baseline)\n");
+   fprintf(fp, "# host %s\n", hostKey().c_str());
+   fprintf(fp, "# benchmark median_seconds p10_seconds p90_seconds\n");
+   for( unsigned int i = 0; i < results.size(); ++i )
+      fprintf(fp, "%s %.6f %.6f %.6f\n", results[i].name.c_str(), results[i].median, results[i].p10, results[i].p90);
+   fclose(fp);
+   return true;
+}
+
+int main(int argc, char const *argv[])
+{
+   int repeats = BENCH_REPEATS;
+   double threshold = BENCH_THRESHOLD;
+   const char* baselineFile = NULL;
+   bool storeBaseline = false;
+
+   /* read options */
+   while( argc > 1 && argv[1][0] == '-' )
+   {
+      if( !strcmp(argv[1], "-r") && argc > 2 )
+      {
+         repeats = std::max(atoi(argv[2]), 1);
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "-t") && argc > 2 )
+      {
+         threshold = atof(argv[2]);
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "-b") && argc > 2 )
+      {
+         baselineFile = argv[2];
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "-w") )
+      {
+         storeBaseline = true;
+         argc--;
+         argv++;
+      }
+      else
+         break;
+   }
+   if( argc < 2 || (storeBaseline && baselineFile == NULL) )
+   {
+      printf("Usage: solchecker_bench [-r repeats] [-t threshold] [-b baseline [-w]] instancedir ...\n");
+      return 0;
+   }
+
+   std::vector<BenchResult> results;
+
+   /* arithmetic */
+   std::vector<std::string> numbers;
+   makeNumbers(numbers);
+   std::vector<Rational> values(numbers.size());
+   results.push_back(runBench("fromString", repeats, [&]()
+   {
+      for( unsigned int i = 0; i < numbers.size(); ++i )
+         values[i].fromString(numbers[i].c_str());
+   }));
+   results.push_back(runBench("addProduct", repeats, [&]()
+   {
+      /* small times small, small times long, and long times long products */
+      Rational sum;
+      for( unsigned int i = 0; i + 1 < values.size(); ++i )
+         sum.addProduct(values[i], values[i + 1]);
+   }));
+
+   /* row activity kernels of the filtered checks (the vectorized one if the CPU has it) */
+   BenchMatrix matrix;
+   makeMatrix(matrix);
+   results.push_back(runBench("rowActivity/scalar", repeats, [&]()
+   {
+      allRowActivities(matrix, rowActivityScalar);
+   }));
+   if( cpuHasAvx2() )
+   {
+      results.push_back(runBench("rowActivity/avx2", repeats, [&]()
+      {
+         allRowActivities(matrix, rowActivityAvx2);
+      }));
+   }
+
+   /* reading and checking the instances */
+   std::vector<std::string> instances;
+   for( int i = 1; i < argc; ++i )
+      collectInstances(argv[i], instances);
+   char solfile[] = "/tmp/solchecker_bench_XXXXXX";
+   int fd = mkstemp(solfile);
+   if( fd < 0 )
+   {
+      printf("cannot create a temporary solution file\n");
+      return 1;
+   }
+   close(fd);
+
+   /* the readers print their warnings; only the report of the benchmarks goes to stdout */
+   fflush(stdout);
+   int savedStdout = dup(STDOUT_FILENO);
+   if( freopen("/dev/null", "w", stdout) == NULL )
+      return 1;
+   for( unsigned int i = 0; i < instances.size(); ++i )
+   {
+      const char* filename = instances[i].c_str();
+      std::string name = instanceName(instances[i]);
+      results.push_back(runBench("readMps/" + name, repeats, [&]()
+      {
+         Model model;
+         MpsInput mpsi;
+         mpsi.readMps(filename, &model);
+      }));
+
+      Model model;
+      MpsInput mpsi;
+      if( !mpsi.readMps(filename, &model) || !writeSolution(&model, solfile) )
+         continue;
+      results.push_back(runBench("readSol/" + name, repeats, [&]()
+      {
+         model.readSol(solfile);
+      }));
+
+      Rational tolerance(1, 10000);
+      results.push_back(runBench("check/" + name, repeats, [&]()
+      {
+         bool intFeasible;
+         bool linearFeasible;
+         bool correctObj;
+         model.check(tolerance, tolerance, intFeasible, linearFeasible, correctObj);
+      }));
+   }
+   fflush(stdout);
+   dup2(savedStdout, STDOUT_FILENO);
+   close(savedStdout);
+   unlink(solfile);
+
+   /* report and compare with the baseline */
+   std::map<std::string, BenchResult> baseline;
+   std::string host;
+   bool compare = (baselineFile != NULL && !storeBaseline);
+   if( compare && access(baselineFile, F_OK) != 0 )
+   {
+      printf("no baseline <%s>, storing the timings of this run as baseline\n", baselineFile);
+      compare = false;
+      storeBaseline = true;
+   }
+   else if( compare && !readBaseline(baselineFile, baseline, host) )
+   {
+      printf("cannot read baseline <%s>, nothing to compare with\n", baselineFile);
+      compare = false;
+   }
+   else if( compare && host != hostKey() )
+   {
+      printf("baseline <%s> was taken on another machine (%s, this is %s), not compared with;\n"
+         "store a baseline of this machine with make bench-baseline\n", baselineFile, host.empty() ? "unknown" : host.c_str(), hostKey().c_str());
+      compare = false;
+   }
+   int nregressions = 0;
+   printf("%-28s %12s %12s %12s %12s %8s\n", "benchmark", "median [s]", "p10 [s]", "p90 [s]", "baseline [s]", "change");
+   for( unsigned int i = 0; i < results.size(); ++i )
+   {
+      const BenchResult& result = results[i];
+      printf("%-28s %12.6f %12.6f %12.6f", result.name.c_str(), result.median, result.p10, result.p90);
+      std::map<std::string, BenchResult>::const_iterator itr = baseline.find(result.name);
+      if( compare && itr != baseline.end() && itr->second.median > 0.0 )
+      {
+         const BenchResult& base = itr->second;
+         double change = result.median / base.median - 1.0;
+         bool regression = (change > threshold && result.median - base.median > BENCH_MINDIFF && result.p10 > base.p90);
+         printf(" %12.6f %+7.1f%%%s", base.median, 100.0 * change, regression ? " REGRESSION" : "");
+         nregressions += regression;
+      }
+      printf("\n");
+   }
+
+   if( storeBaseline )
+   {
+      if( !writeBaseline(baselineFile, results) )
+      {
+         printf("cannot write baseline <%s>\n", baselineFile);
+         return 1;
+      }
+      printf("baseline written to <%s>\n", baselineFile);
+   }
+   if( nregressions > 0 )
+   {
+      printf("%d benchmarks are more than %.0f%% slower than the baseline\n", nregressions, 100.0 * threshold);
+      return 1;
+   }
+   return 0;
+}
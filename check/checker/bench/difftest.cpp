@@ -0,0 +1,229 @@
+/**
+ * @file difftest.cpp
+ * @brief Differential test of IncrementalCheck against Model::evaluate() (see "make test")
+ *
+ * Each instance is checked at a starting solution, and then through a sequence of random
+ * deltas: a few variables at a time are moved to zero, one, one of their bounds, a random
+ * fraction, or next to their current value, and the objective value given by the solver
+ * is changed now and then. After each delta the verdicts and violations of
+ * IncrementalCheck::evaluate() must be the same as the ones of Model::evaluate() checking
+ * the whole solution from scratch (with 1 to 3 threads in turn). The deltas are drawn from
+ * a fixed seed, so a failure can be reproduced; the run fails if any result differs.
+ */
+
+#include "model.h"
+#include "mpsinput.h"
+#include "incremental.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+/* default number of random deltas per instance */
+#define TEST_DELTAS      300
+/* default seed of the random deltas */
+#define TEST_SEED        1
+/* largest number of variables changed by a delta */
+#define TEST_MAXCHANGES  4
+/* number of mismatches printed per instance */
+#define TEST_MAXPRINT    3
+
+/* collect the MPS files of a directory, sorted by name */
+static void collectInstances(const char* dir, std::vector<std::string>& files)
+{
+   DIR* d = opendir(dir);
+   if( d == NULL )
+   {
+      printf("cannot open directory <%s>\n", dir);
+      return;
+   }
+   std::vector<std::string> names;
+   struct dirent* entry;
+   while( (entry = readdir(d)) != NULL )
+   {
+      const char* name = entry->d_name;
+      size_t len = strlen(name);
+      if( (len > 4 && !strcmp(name + len - 4, ".mps")) || (len > 7 && !strcmp(name + len - 7, ".mps.gz")) )
+         names.push_back(name);
+   }
+   closedir(d);
+   std::sort(names.begin(), names.end());
+   for( unsigned int i = 0; i < names.size(); ++i )
+      files.push_back(std::string(dir) + "/" + names[i]);
+}
+
+/* differences between two check results, as a readable list (empty if they agree) */
+static std::string compareResults(const CheckResult& inc, const CheckResult& full)
+{
+   std::string diff;
+   if( inc.intFeasible != full.intFeasible )
+      diff += " intFeasible";
+   if( inc.linearFeasible != full.linearFeasible )
+      diff += " linearFeasible";
+   if( inc.correctObj != full.correctObj )
+      diff += " correctObj";
+   if( inc.intViol != full.intViol )
+      diff += " intViol(" + inc.intViol.toString() + " vs " + full.intViol.toString() + ")";
+   if( inc.linearViol != full.linearViol )
+      diff += " linearViol(" + inc.linearViol.toString() + " vs " + full.linearViol.toString() + ")";
+   if( inc.objViol != full.objViol )
+      diff += " objViol(" + inc.objViol.toString() + " vs " + full.objViol.toString() + ")";
+   if( inc.objVal != full.objVal )
+      diff += " objVal(" + inc.objVal.toString() + " vs " + full.objVal.toString() + ")";
+   if( inc.firstVarFailure != full.firstVarFailure )
+      diff += " firstVarFailure(" + std::to_string(inc.firstVarFailure) + " vs " + std::to_string(full.firstVarFailure) + ")";
+   if( inc.firstConsFailure != full.firstConsFailure )
+      diff += " firstConsFailure(" + std::to_string(inc.firstConsFailure) + " vs " + std::to_string(full.firstConsFailure) + ")";
+   return diff;
+}
+
+/* random value for variable @param var with current value @param current */
+static Rational randomValue(const Var* var, const Rational& current, std::mt19937& rng)
+{
+   switch( rng() % 7 )
+   {
+   case 0:
+      return Rational(0);
+   case 1:
+      return Rational(1);
+   case 2:
+      return var->lb;
+   case 3:
+      return var->ub;
+   case 4:
+   {
+      /* current value moved by a small amount, inside or just outside a tolerance */
+      Rational value = current;
+      value.addProduct(Rational((int)(rng() % 3) - 1), Rational(1, (rng() % 2 == 0 ? 1 : 20000)));
+      return value;
+   }
+   default:
+      return Rational((int)(rng() % 2001) - 1000, (int)(rng() % 7) + 1);
+   }
+}
+
+/* run the random deltas on an instance, return the number of mismatches */
+static int testInstance(const char* filename, int ndeltas, unsigned int seed)
+{
+   Model model;
+   MpsInput mpsi;
+
+   /* the reader prints its warnings; only the report of the test goes to stdout */
+   fflush(stdout);
+   int savedStdout = dup(STDOUT_FILENO);
+   if( freopen("/dev/null", "w", stdout) == NULL )
+      return 1;
+   bool read = mpsi.readMps(filename, &model);
+   fflush(stdout);
+   dup2(savedStdout, STDOUT_FILENO);
+   close(savedStdout);
+   if( !read )
+   {
+      printf("%-40s cannot read instance\n", filename);
+      return 1;
+   }
+
+   Rational tolerance(1, 10000);
+   std::mt19937 rng(seed);
+   int mismatches = 0;
+   IncrementalCheck incremental(&model, tolerance, tolerance);
+
+   /* the starting solution: every variable at the bound closest to zero */
+   for( unsigned int j = 0; j < model.numVars(); ++j )
+   {
+      const Var* var = model.getVar(j);
+      if( var->lb.isPositive() )
+         incremental.set(j, var->lb);
+      else if( var->ub.isNegative() )
+         incremental.set(j, var->ub);
+   }
+
+   for( int delta = 0; delta <= ndeltas && model.numVars() > 0; ++delta )
+   {
+      if( delta > 0 )
+      {
+         int nchanges = 1 + rng() % TEST_MAXCHANGES;
+         for( int c = 0; c < nchanges; ++c )
+         {
+            unsigned int j = rng() % model.numVars();
+            incremental.set(j, randomValue(model.getVar(j), model.solution[j], rng));
+         }
+         /* objective value given by the solver: none, the correct one, or a wrong one */
+         if( rng() % 10 == 0 )
+         {
+            model.hasObjectiveValue = (rng() % 3 != 0);
+            model.objectiveValue = Rational((int)(rng() % 201) - 100);
+         }
+      }
+
+      CheckResult inc;
+      CheckResult full;
+      incremental.evaluate(inc);
+      if( model.hasObjectiveValue && rng() % 2 == 0 )
+      {
+         /* the correct objective value, so that correctObj is not always false */
+         model.objectiveValue = inc.objVal;
+         incremental.evaluate(inc);
+      }
+      model.evaluate(tolerance, tolerance, full, 1 + delta % 3);
+
+      std::string diff = compareResults(inc, full);
+      if( !diff.empty() )
+      {
+         if( mismatches < TEST_MAXPRINT )
+            printf("%s: delta %d differs:%s\n", filename, delta, diff.c_str());
+         mismatches++;
+      }
+   }
+   printf("%-40s %4d deltas %s\n", filename, ndeltas, mismatches == 0 ? "ok" : "FAILED");
+   return mismatches;
+}
+
+int main(int argc, char const *argv[])
+{
+   int ndeltas = TEST_DELTAS;
+   unsigned int seed = TEST_SEED;
+
+   /* read options */
+   while( argc > 1 && argv[1][0] == '-' )
+   {
+      if( !strcmp(argv[1], "-n") && argc > 2 )
+      {
+         ndeltas = std::max(atoi(argv[2]), 0);
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "-s") && argc > 2 )
+      {
+         seed = (unsigned int)strtoul(argv[2], NULL, 10);
+         argc -= 2;
+         argv += 2;
+      }
+      else
+         break;
+   }
+   if( argc < 2 )
+   {
+      printf("Usage: solchecker_test [-n deltas] [-s seed] instancedir ...\n");
+      return 0;
+   }
+
+   std::vector<std::string> instances;
+   for( int i = 1; i < argc; ++i )
+      collectInstances(argv[i], instances);
+
+   int failed = 0;
+   for( unsigned int i = 0; i < instances.size(); ++i )
+   {
+      if( testInstance(instances[i].c_str(), ndeltas, seed + i) > 0 )
+         failed++;
+   }
+   printf("%d of %d instances failed\n", failed, (int)instances.size());
+   return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file arena.h
+ * @brief Bump allocation and string interning for model objects
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/* size of the blocks memory is taken from */
+#define ARENA_BLOCKSIZE (1 << 20)
+
+/**
+ * @brief Bump allocator for objects that live as long as their owner.
+ * Memory is taken from large blocks and released all at once when the arena is destroyed.
+ * Objects created in the arena must not be deleted. Destructors are run at teardown only
+ * for types that have a non-trivial one, and without freeing any memory per object;
+ * objects of the same type created one after the other share a single cleanup record.
+ */
+class Arena
+{
+   public:
+      /** Constructor */
+      Arena():pos(NULL), end(NULL) {}
+
+      /** Destructor: runs the registered destructors (latest first) and frees all blocks */
+      ~Arena()
+      {
+         for( size_t i = cleanups.size(); i-- > 0; )
+         {
+            for( size_t k = cleanups[i].count; k-- > 0; )
+               cleanups[i].destroy(cleanups[i].first + k * cleanups[i].size);
+         }
+         for( unsigned int i = 0; i < blocks.size(); ++i )
+            free(blocks[i]);
+      }
+
+      /**
+       * Allocate uninitialized memory
+       * @param size number of bytes
+       * @param align alignment, a power of two not larger than the one of malloc()
+       */
+      void* allocate(size_t size, size_t align = alignof(max_align_t))
+      {
+         char* res = (char*)(((size_t)pos + align - 1) & ~(align - 1));
+         if( pos == NULL || res + size > end )
+         {
+            /* large requests get a block of their own, so the current block is kept */
+            if( size > ARENA_BLOCKSIZE / 4 )
+               return newBlock(size);
+            pos = newBlock(ARENA_BLOCKSIZE);
+            end = pos + ARENA_BLOCKSIZE;
+            res = pos;
+         }
+         pos = res + size;
+         return res;
+      }
+
+      /**
+       * Create an object in the arena
+       * @param args arguments for the constructor of T
+       */
+      template <class T, class... Args>
+      T* create(Args&&... args)
+      {
+         T* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+         if( !std::is_trivially_destructible<T>::value )
+         {
+            Cleanup* last = (cleanups.empty() ? NULL : &cleanups.back());
+            if( last != NULL && last->destroy == &destroy<T> && last->first + last->count * sizeof(T) == (char*)obj )
+               last->count++;
+            else
+            {
+               Cleanup c = { &destroy<T>, (char*)obj, 1, sizeof(T) };
+               cleanups.push_back(c);
+            }
+         }
+         return obj;
+      }
+
+      /** Copy the null-terminated string @param str (of length @param len) into the arena */
+      const char* copy(const char* str, size_t len)
+      {
+         char* res = (char*)allocate(len + 1, 1);
+         memcpy(res, str, len + 1);
+         return res;
+      }
+
+   protected:
+      /* destructor to run at teardown on count consecutive objects of the given size */
+      struct Cleanup
+      {
+         void (*destroy)(void*);
+         char* first;
+         size_t count;
+         size_t size;
+      };
+
+      template <class T>
+      static void destroy(void* object)
+      {
+         ((T*)object)->~T();
+      }
+
+      char* newBlock(size_t size)
+      {
+         char* block = (char*)malloc(size);
+         if( block == NULL )
+            throw std::bad_alloc();
+         blocks.push_back(block);
+         return block;
+      }
+
+      /* next free byte of the current block */
+      char* pos;
+      /* end of the current block */
+      char* end;
+      /* all blocks */
+      std::vector<char*> blocks;
+      /* destructors to run at teardown */
+      std::vector<Cleanup> cleanups;
+};
+
+/**
+ * @brief Pool of interned strings: each distinct string is stored once, in an arena owned
+ * by the pool, so that the pooled copies live as long as the pool and can be compared by address.
+ */
+class StringPool
+{
+   public:
+      /** Constructor */
+      StringPool():count(0) {}
+
+      /** Get the pooled copy of @param str, adding it to the pool if needed */
+      const char* intern(const char* str)
+      {
+         /* keep the table at most half full */
+         if( 2 * (count + 1) > table.size() )
+            grow();
+         size_t slot = lookup(str);
+         if( table[slot] == NULL )
+         {
+            table[slot] = arena.copy(str, strlen(str));
+            count++;
+         }
+         return table[slot];
+      }
+
+      /** Get the pooled copy of @param str, or NULL if it is not in the pool */
+      const char* find(const char* str) const
+      {
+         return table.empty() ? NULL : table[lookup(str)];
+      }
+
+   protected:
+      /* slot of str in the table (open addressing with linear probing), or the empty slot to insert it */
+      size_t lookup(const char* str) const
+      {
+         size_t mask = table.size() - 1;
+         size_t slot = hash(str) & mask;
+         while( table[slot] != NULL && strcmp(table[slot], str) != 0 )
+            slot = (slot + 1) & mask;
+         return slot;
+      }
+
+      /* hash of a string (FNV-1a) */
+      static size_t hash(const char* str)
+      {
+         size_t res = (size_t)14695981039346656037ULL;
+         for( ; *str != '\0'; ++str )
+            res = (res ^ (unsigned char)*str) * (size_t)1099511628211ULL;
+         return res;
+      }
+
+      void grow()
+      {
+         std::vector<const char*> old(table.empty() ? 64 : 2 * table.size(), (const char*)NULL);
+         old.swap(table);
+         for( size_t i = 0; i < old.size(); ++i )
+         {
+            if( old[i] != NULL )
+               table[lookup(old[i])] = old[i];
+         }
+      }
+
+      /* memory of the strings */
+      Arena arena;
+      /* hash table of the pooled strings (NULL for empty slots), its size is a power of two */
+      std::vector<const char*> table;
+      /* number of pooled strings */
+      size_t count;
+};
+
+#endif
@@ -0,0 +1,431 @@
+/**
+ * @file cplexsolinput.cpp
+ * @brief CPLEX XML solution reader class
+ */
+
+#include "cplexsolinput.h"
+#include "model.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+#include <algorithm>
+
+#define CPLEXSOL_BLOCKSIZE  (1 << 20)
+#define CPLEXSOL_MAX_READ   (1 << 30)
+#define CPLEXSOL_GZBUFFER   (1 << 18)
+#define CPLEXSOL_SNIFFLEN   256
+
+/* store the UTF-8 encoding of the character \p code at \p out, return its length */
+static int encodeUtf8(
+      unsigned long         code,
+      char*                 out
+      )
+{
+   if( code < 0x80 )
+   {
+      out[0] = (char)code;
+      return 1;
+   }
+   if( code < 0x800 )
+   {
+      out[0] = (char)(0xC0 | (code >> 6));
+      out[1] = (char)(0x80 | (code & 0x3F));
+      return 2;
+   }
+   if( code < 0x10000 )
+   {
+      out[0] = (char)(0xE0 | (code >> 12));
+      out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+      out[2] = (char)(0x80 | (code & 0x3F));
+      return 3;
+   }
+   out[0] = (char)(0xF0 | (code >> 18));
+   out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+   out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+   out[3] = (char)(0x80 | (code & 0x3F));
+   return 4;
+}
+
+/* replace the character and entity references in the attribute value \p str in place.
+ * Unknown references are kept as they are. */
+static void decodeEntities(
+      char*                 str
+      )
+{
+   char* out = str;
+   for( char* in = str; *in != '\0'; )
+   {
+      if( *in != '&' )
+      {
+         *out++ = *in++;
+         continue;
+      }
+      char* semi = strchr(in, ';');
+      if( semi != NULL )
+      {
+         size_t len = semi - in - 1;
+         const char* ref = in + 1;
+         char c = '\0';
+         int replaced = 0;
+         if( len == 3 && strncmp(ref, "amp", 3) == 0 )
+            c = '&';
+         else if( len == 2 && strncmp(ref, "lt", 2) == 0 )
+            c = '<';
+         else if( len == 2 && strncmp(ref, "gt", 2) == 0 )
+            c = '>';
+         else if( len == 4 && strncmp(ref, "quot", 4) == 0 )
+            c = '"';
+         else if( len == 4 && strncmp(ref, "apos", 4) == 0 )
+            c = '\'';
+         else if( len >= 2 && ref[0] == '#' )
+         {
+            char* end;
+            unsigned long code = (ref[1] == 'x' ? strtoul(ref + 2, &end, 16) : strtoul(ref + 1, &end, 10));
+            /* the encoding is never longer than the reference */
+            if( end == semi && code > 0 && code <= 0x10FFFF )
+               replaced = encodeUtf8(code, out);
+         }
+         if( c != '\0' )
+         {
+            *out = c;
+            replaced = 1;
+         }
+         if( replaced > 0 )
+         {
+            out += replaced;
+            in = semi + 1;
+            continue;
+         }
+      }
+      *out++ = *in++;
+   }
+   *out = '\0';
+}
+
+/* split off the next attribute of a tag starting at \p pos, terminating its name and its
+ * value in place. Returns false if there is no attribute left. */
+static bool nextAttribute(
+      char*&                pos,
+      char*&                name,
+      char*&                value
+      )
+{
+   while( isspace((unsigned char)*pos) )
+      ++pos;
+   if( *pos == '\0' || *pos == '/' || *pos == '?' )
+      return false;
+   name = pos;
+   while( *pos != '\0' && *pos != '=' && !isspace((unsigned char)*pos) )
+      ++pos;
+   char* nameEnd = pos;
+   while( isspace((unsigned char)*pos) )
+      ++pos;
+   if( *pos != '=' )
+      return false;
+   ++pos;
+   while( isspace((unsigned char)*pos) )
+      ++pos;
+   char quote = *pos;
+   if( quote != '"' && quote != '\'' )
+      return false;
+   value = ++pos;
+   while( *pos != '\0' && *pos != quote )
+      ++pos;
+   if( *pos == '\0' )
+      return false;
+   *pos++ = '\0';
+   *nameEnd = '\0';
+   decodeEntities(value);
+   return true;
+}
+
+CplexSolInput::CplexSolInput()
+{
+   model       = NULL;
+   pool        = NULL;
+   current     = NULL;
+   gzfp        = NULL;
+   blockPos    = 0;
+   blockEnd    = 0;
+   blockEof    = false;
+   hasVarValue = false;
+   nunexpectedvars = 0;
+}
+
+bool CplexSolInput::isXml(const char* filename)
+{
+   assert( filename != NULL );
+   gzFile fp = gzopen(filename, "r");
+   if( fp == NULL )
+      return false;
+   unsigned char buf[CPLEXSOL_SNIFFLEN];
+   int len = gzread(fp, buf, sizeof(buf));
+   gzclose(fp);
+
+   int pos = 0;
+   /* skip a byte order mark */
+   if( len >= 3 && buf[0] == 0xEF && buf[1] == 0xBB && buf[2] == 0xBF )
+      pos = 3;
+   while( pos < len && isspace(buf[pos]) )
+      ++pos;
+   return pos < len && buf[pos] == '<';
+}
+
+/* move the unparsed data to the front of the block and read more input behind it.
+ * The block grows if a single tag does not fit. Returns false at the end of the input. */
+bool CplexSolInput::fillBlock()
+{
+   if( blockEof )
+      return false;
+
+   size_t rest = blockEnd - blockPos;
+   if( rest > 0 && blockPos > 0 )
+      memmove(&block[0], &block[blockPos], rest);
+   blockPos = 0;
+   blockEnd = rest;
+   if( blockEnd + 1 >= block.size() )
+      block.resize(2 * block.size());
+
+   /* keep one byte to terminate the data */
+   size_t space = std::min(block.size() - 1 - blockEnd, (size_t)CPLEXSOL_MAX_READ);
+   int ret = gzread(gzfp, &block[blockEnd], space);
+   size_t nread = (ret > 0 ? ret : 0);
+   if( nread == 0 )
+      blockEof = true;
+   blockEnd += nread;
+   block[blockEnd] = '\0';
+   return nread > 0;
+}
+
+/* get the contents of the next tag (without the angle brackets), terminated in place.
+ * Comments, text and incomplete tags at the end of the input are skipped.
+ * The contents stay valid until the next call. Returns false at the end of the input. */
+bool CplexSolInput::nextTag(
+      char*&                tag,
+      size_t&               len
+      )
+{
+   while( true )
+   {
+      char* beg = &block[blockPos];
+      char* lt = (char*)memchr(beg, '<', blockEnd - blockPos);
+      if( lt == NULL )
+      {
+         /* only text is left */
+         blockPos = blockEnd;
+         if( !fillBlock() )
+            return false;
+         continue;
+      }
+      blockPos = lt - &block[0];
+      size_t avail = blockEnd - blockPos;
+
+      /* find the end of the tag, where '>' can be in quoted attribute values */
+      char* end = NULL;
+      if( avail >= 4 && strncmp(lt, "<!--", 4) == 0 )
+      {
+         char* close = strstr(lt + 4, "-->");
+         if( close != NULL )
+         {
+            blockPos = close + 3 - &block[0];
+            continue;
+         }
+      }
+      else
+      {
+         char quote = '\0';
+         for( char* p = lt + 1; p < lt + avail; ++p )
+         {
+            if( quote != '\0' )
+            {
+               if( *p == quote )
+                  quote = '\0';
+            }
+            else if( *p == '"' || *p == '\'' )
+               quote = *p;
+            else if( *p == '>' )
+            {
+               end = p;
+               break;
+            }
+         }
+      }
+
+      if( end == NULL )
+      {
+         /* the tag goes on in the input not read yet */
+         if( !fillBlock() )
+         {
+            blockPos = blockEnd;
+            return false;
+         }
+         continue;
+      }
+
+      *end = '\0';
+      tag = lt + 1;
+      len = end - tag;
+      blockPos = end + 1 - &block[0];
+      return true;
+   }
+}
+
+/* read the objective value (and the name of a pool solution) from the attributes of the header */
+void CplexSolInput::readHeader(
+      char*                 attrs
+      )
+{
+   char* name;
+   char* value;
+   while( nextAttribute(attrs, name, value) )
+   {
+      if( strcmp(name, "objectiveValue") == 0 )
+      {
+         if( current != NULL )
+         {
+            current->hasObjectiveValue = true;
+            current->objectiveValue.fromString(value);
+         }
+         else
+         {
+            model->hasObjectiveValue = true;
+            model->objectiveValue.fromString(value);
+         }
+      }
+      else if( strcmp(name, "solutionName") == 0 && current != NULL )
+         current->name = value;
+   }
+}
+
+/* read the value of a variable from its attributes */
+void CplexSolInput::readVariable(
+      char*                 attrs
+      )
+{
+   const char* varname = NULL;
+   const char* valuep = NULL;
+   const char* indexp = NULL;
+   char* name;
+   char* value;
+   while( nextAttribute(attrs, name, value) )
+   {
+      if( strcmp(name, "name") == 0 )
+         varname = value;
+      else if( strcmp(name, "value") == 0 )
+         valuep = value;
+      else if( strcmp(name, "index") == 0 )
+         indexp = value;
+   }
+   if( varname == NULL || valuep == NULL )
+      return;
+
+   /* CPLEX numbers the columns in the order of the MPS file, so the index usually
+    * points to the variable already; the name decides */
+   Var* var = NULL;
+   if( indexp != NULL )
+   {
+      long index = atol(indexp);
+      if( index >= 0 && index < (long)model->numVars() )
+      {
+         var = model->getVar((unsigned int)index);
+         if( strcmp(var->name, varname) != 0 )
+            var = NULL;
+      }
+   }
+   if( var == NULL )
+      var = model->getVar(varname);
+
+   if( var != NULL )
+   {
+      Rational val;
+      val.fromString(valuep);
+      if( current != NULL )
+      {
+         current->indices.push_back(var->index);
+         current->values.push_back(val);
+      }
+      else
+         model->solution.set(var->index, val);
+      hasVarValue = true;
+   }
+   else
+   {
+      ++nunexpectedvars;
+      printf("unexpected variable <%s> in solution file\n", varname);
+   }
+}
+
+bool CplexSolInput::readSol(
+      const char*           _filename,
+      Model*                _model,
+      std::vector<PoolSolution>* _pool
+      )
+{
+   assert( _filename != NULL );
+   assert( _model != NULL );
+
+   gzfp = gzopen(_filename, "r");
+   if( gzfp == NULL )
+   {
+      printf("cannot open file <%s> for reading\n", _filename);
+      return false;
+   }
+   gzbuffer(gzfp, CPLEXSOL_GZBUFFER);
+
+   model = _model;
+   pool = _pool;
+   current = NULL;
+   if( pool != NULL )
+   {
+      /* for values outside of a CPLEXSolution element */
+      pool->push_back(PoolSolution());
+      current = &pool->back();
+   }
+   block.resize(CPLEXSOL_BLOCKSIZE);
+   blockPos = 0;
+   blockEnd = 0;
+   blockEof = false;
+   block[0] = '\0';
+   hasVarValue = false;
+   nunexpectedvars = 0;
+
+   char* tag;
+   size_t len;
+   while( nextTag(tag, len) )
+   {
+      /* split the name of the tag from its attributes */
+      char* attrs = (tag[0] == '/' ? tag + 1 : tag);
+      while( *attrs != '\0' && *attrs != '/' && !isspace((unsigned char)*attrs) )
+         ++attrs;
+      size_t namelen = attrs - tag;
+
+      if( namelen == 8 && strncmp(tag, "variable", 8) == 0 )
+         readVariable(attrs);
+      else if( namelen == 6 && strncmp(tag, "header", 6) == 0 )
+         readHeader(attrs);
+      else if( namelen == 13 && strncmp(tag, "CPLEXSolution", 13) == 0 && current != NULL )
+      {
+         if( !current->indices.empty() || current->hasObjectiveValue )
+         {
+            pool->push_back(PoolSolution());
+            current = &pool->back();
+         }
+      }
+      else if( namelen == 14 && strncmp(tag, "/CPLEXSolution", 14) == 0 && current == NULL )
+         break;
+   }
+
+   if( nunexpectedvars > 0 )
+      printf("Encountered %d unexpected variables\n", nunexpectedvars);
+
+   model = NULL;
+   pool = NULL;
+   current = NULL;
+   std::vector<char>().swap(block);
+   gzclose(gzfp);
+   gzfp = NULL;
+
+   return hasVarValue;
+}
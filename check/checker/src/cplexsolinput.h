@@ -0,0 +1,62 @@
+/**
+ * @file cplexsolinput.h
+ * @brief CPLEX XML solution reader class
+ */
+
+#ifndef CPLEXSOLINPUT_H
+#define CPLEXSOLINPUT_H
+
+#include <vector>
+#include <zlib.h>
+
+class Model;
+class PoolSolution;
+
+/**
+ * @brief CPLEX XML solution reader class.
+ * It reads a solution file written by CPLEX (possibly gzipped) in a single pass:
+ * input is read in large blocks and the tags are scanned in place, so the document is
+ * never held in memory as a whole. Only the objective value of the header and the values
+ * of the variables are used; variable names are resolved to positions in the model
+ * right away. If the file holds several solutions, only the first one is read into the
+ * model, unless all of them are read into a solution pool.
+ */
+class CplexSolInput
+{
+   public:
+      CplexSolInput();
+
+      /**
+       * @brief tells whether a file looks like an XML document, i.e. starts with a tag
+       * @param filename path to the file (may be gzipped)
+       */
+      static bool isXml(const char* filename);
+
+      /**
+       * @brief reads the solution values of a CPLEX XML solution file into the solution of a model.
+       * Like Model::readSol(), which calls it, it does not clear the solution first.
+       * @param _filename path to the solution file (may be gzipped)
+       * @param _model model to resolve the variable names with, and to store the values in
+       * @param _pool stores every solution of the file instead (NULL to read the first one into the model)
+       * @return true if the file was read and has some variable value, false otherwise
+       */
+      bool readSol(const char* _filename, Model* _model, std::vector<PoolSolution>* _pool = NULL);
+   protected:
+      Model*        model; //< model to fill
+      std::vector<PoolSolution>* pool; //< pool to fill instead, if not NULL
+      PoolSolution* current; //< solution of the pool being read
+      gzFile        gzfp; //< gzFile pointer, plain files are read through it as well
+      std::vector<char> block; //< block of input data, tags are parsed in place
+      size_t        blockPos; //< start of the unparsed data in the block
+      size_t        blockEnd; //< end of the data read into the block
+      bool          blockEof; //< has all input been read into the block?
+      bool          hasVarValue; //< was a variable value read?
+      int           nunexpectedvars; //< number of names not found in the model
+
+      bool fillBlock();
+      bool nextTag(char*& tag, size_t& len);
+      void readHeader(char* attrs);
+      void readVariable(char* attrs);
+};
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file fingerprint.cpp
+ * @brief Content-addressed fingerprints of MIP models
+ */
+
+#include "fingerprint.h"
+#include "model.h"
+#include "hash.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#define FINGERPRINT_CHUNK    1024
+/* part of every fingerprint, to be changed with the canonical form */
+#define FINGERPRINT_VERSION  2
+
+/* adds the parts of a canonical record to a hash */
+class RecordHasher
+{
+   public:
+      uint64_t hash;
+
+      RecordHasher():hash(HASH_SEED) {}
+
+      void putInt(int64_t value)
+      {
+         hash = hashWord(hash, (uint64_t)value);
+      }
+
+      /* names are hashed with their terminating zero, so that consecutive names cannot run together */
+      void putName(const char* name)
+      {
+         hash = hashBytes(hash, (const unsigned char*)name, strlen(name) + 1);
+      }
+
+      /* numbers are hashed as the 64-bit words of their reduced numerator and denominator,
+       * least significant first, so that the hash depends neither on the limb size of GMP
+       * nor on the byte order of the host */
+      void putRational(const Rational& value)
+      {
+         int numSize;
+         int denSize;
+         value.limbSizes(numSize, denSize);
+         limbs.resize(abs(numSize) + denSize);
+         value.toLimbs(&limbs[0]);
+         int numWords = numberOfWords(abs(numSize));
+         putInt(numSize < 0 ? -numWords : numWords);
+         putInt(numberOfWords(denSize));
+         putWords(&limbs[0], abs(numSize));
+         putWords(&limbs[abs(numSize)], denSize);
+      }
+
+   protected:
+      /* limbs that make up a 64-bit word */
+      static const int LIMBS_PER_WORD = 64 / GMP_NUMB_BITS;
+
+      std::vector<mp_limb_t> limbs;
+
+      static int numberOfWords(int nlimbs)
+      {
+         return (nlimbs + LIMBS_PER_WORD - 1) / LIMBS_PER_WORD;
+      }
+
+      /* hash @param nlimbs limbs of a number, least significant first, as 64-bit words */
+      void putWords(const mp_limb_t* numberLimbs, int nlimbs)
+      {
+         for( int k = 0; k < nlimbs; k += LIMBS_PER_WORD )
+         {
+            uint64_t word = 0;
+            for( int i = 0; i < LIMBS_PER_WORD && k + i < nlimbs; ++i )
+               word |= (uint64_t)numberLimbs[k + i] << (i * GMP_NUMB_BITS);
+            hash = hashWord(hash, word);
+         }
+      }
+};
+
+/* positions of @param n names, in name order */
+template <class GetName>
+static std::vector<int> nameOrder(unsigned int n, GetName getName)
+{
+   std::vector<int> order(n);
+   for( unsigned int i = 0; i < n; ++i )
+      order[i] = i;
+   std::sort(order.begin(), order.end(), [&](int a, int b) { return strcmp(getName(a), getName(b)) < 0; });
+   return order;
+}
+
+/* hash the row of a linear constraint, with its nonzeros in the name order of their variables,
+ * given by the rank of each variable in @param varRank */
+static void putLinear(RecordHasher& hasher, const LinearConstraint* lincons, const std::vector<int>& varRank, std::vector<std::pair<int, int> >& entries)
+{
+   const SparseMatrix& matrix = lincons->model->matrix;
+   hasher.putRational(lincons->lhs());
+   hasher.putRational(lincons->rhs());
+   entries.clear();
+   for( int k = matrix.rowBeg[lincons->row]; k < matrix.rowBeg[lincons->row + 1]; ++k )
+      entries.push_back(std::make_pair(varRank[matrix.rowInd[k]], k));
+   std::sort(entries.begin(), entries.end());
+   hasher.putInt(entries.size());
+   for( unsigned int e = 0; e < entries.size(); ++e )
+   {
+      hasher.putInt(entries[e].first);
+      hasher.putRational(matrix.rowVal[entries[e].second]);
+   }
+}
+
+uint64_t modelFingerprint(const Model* model, int nthreads)
+{
+   unsigned int nvars = model->numVars();
+   unsigned int nconss = model->numConss();
+   std::vector<int> varOrder = nameOrder(nvars, [&](int i) { return model->getVar((unsigned int)i)->name; });
+   std::vector<int> consOrder = nameOrder(nconss, [&](int i) { return model->getCons((unsigned int)i)->name; });
+   /* variables are referred to by their rank in name order, which does not depend on the file */
+   std::vector<int> varRank(nvars);
+   for( unsigned int r = 0; r < nvars; ++r )
+      varRank[varOrder[r]] = r;
+
+   /* hash each record on its own */
+   std::vector<uint64_t> varHash(nvars);
+   parallelFor(nvars, FINGERPRINT_CHUNK, nthreads, [&](unsigned int begin, unsigned int end, int thread)
+   {
+      RecordHasher hasher;
+      for( unsigned int r = begin; r < end; ++r )
+      {
+         const Var* var = model->getVar((unsigned int)varOrder[r]);
+         hasher.hash = HASH_SEED;
+         hasher.putName(var->name);
+         hasher.putInt(var->type);
+         hasher.putRational(var->lb);
+         hasher.putRational(var->ub);
+         hasher.putRational(var->objCoef);
+         varHash[r] = hasher.hash;
+      }
+   });
+   std::vector<uint64_t> consHash(nconss);
+   parallelFor(nconss, FINGERPRINT_CHUNK, nthreads, [&](unsigned int begin, unsigned int end, int thread)
+   {
+      RecordHasher hasher;
+      std::vector<std::pair<int, int> > entries;
+      for( unsigned int r = begin; r < end; ++r )
+      {
+         const Constraint* cons = model->getCons((unsigned int)consOrder[r]);
+         hasher.hash = HASH_SEED;
+         hasher.putName(cons->name);
+         hasher.putName(cons->type);
+         const LinearConstraint* lincons = dynamic_cast<const LinearConstraint*>(cons);
+         const SOSConstraint* soscons = dynamic_cast<const SOSConstraint*>(cons);
+         const IndicatorConstraint* indcons = dynamic_cast<const IndicatorConstraint*>(cons);
+         if( lincons != NULL )
+            putLinear(hasher, lincons, varRank, entries);
+         else if( soscons != NULL )
+         {
+            /* the order of the variables matters for SOS2 */
+            hasher.putInt(soscons->sostype);
+            hasher.putInt(soscons->vars.size());
+            for( unsigned int k = 0; k < soscons->vars.size(); ++k )
+               hasher.putInt(varRank[soscons->vars[k]->index]);
+         }
+         else if( indcons != NULL )
+         {
+            hasher.putInt(varRank[indcons->ifvar->index]);
+            hasher.putInt(indcons->ifvalue);
+            const LinearConstraint* thencons = dynamic_cast<const LinearConstraint*>(indcons->thencons);
+            if( thencons != NULL )
+               putLinear(hasher, thencons, varRank, entries);
+         }
+         consHash[r] = hasher.hash;
+      }
+   });
+
+   /* combine the records in name order */
+   RecordHasher hasher;
+   hasher.putInt(FINGERPRINT_VERSION);
+   hasher.putInt(model->objSense);
+   hasher.putRational(model->objConstant);
+   hasher.putInt(nvars);
+   for( unsigned int r = 0; r < nvars; ++r )
+      hasher.putInt(varHash[r]);
+   hasher.putInt(nconss);
+   for( unsigned int r = 0; r < nconss; ++r )
+      hasher.putInt(consHash[r]);
+   return hasher.hash;
+}
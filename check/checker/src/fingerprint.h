@@ -0,0 +1,29 @@
+/**
+ * @file fingerprint.h
+ * @brief Content-addressed fingerprints of MIP models
+ */
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <stdint.h>
+
+class Model;
+
+/**
+ * Compute the fingerprint of a model: a 64-bit hash of its canonical form, so that two
+ * files holding the same model get the same fingerprint whatever their format (fixed or
+ * free MPS, gzipped or not), the order of their rows, columns and nonzeros, and the way
+ * their numbers are written (numbers are hashed as exact reduced rationals).
+ * The canonical form is the objective sense and constant, then the variables in name
+ * order (name, type, bounds, objective coefficient), then the constraints in name order
+ * (name, type and contents, with the nonzeros of a row in the name order of their
+ * variables). Model and objective names are not part of it.
+ * Every variable and constraint is hashed on its own, spread over @param nthreads threads;
+ * the record hashes are then combined in name order.
+ * @param model model to fingerprint (finalized)
+ * @return the fingerprint
+ */
+uint64_t modelFingerprint(const Model* model, int nthreads = 1);
+
+#endif
@@ -6,107 +6,319 @@
 #include "gmputils.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <assert.h>
+#include <ctype.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+#include <vector>
 
-char Rational::buffer[] = {'\0'};
+/* the GMP views of inline values hold each of numerator and denominator in one limb */
+static_assert(GMP_LIMB_BITS >= 64, "GMP limbs must have at least 64 bits");
 
-Rational::Rational(int num, int den)
+/* absolute value of an inline numerator */
+static uint64_t uabs(int64_t val)
 {
-   mpq_init(number);
-   mpq_set_si(number, num, den);
-   mpq_canonicalize(number);
+   return val < 0 ? -(uint64_t)val : (uint64_t)val;
 }
 
-Rational::Rational(double frac)
+static uint64_t gcd(uint64_t a, uint64_t b)
 {
-   mpq_init(number);
-   mpq_set_d(number, frac);
-   mpq_canonicalize(number);
+   while( b != 0 )
+   {
+      uint64_t r = a % b;
+      a = b;
+      b = r;
+   }
+   return a;
+}
+
+/* does the reduced fraction n/d (d > 0) fit inline? */
+static bool fitsSmall(__int128 n, __int128 d)
+{
+   return n <= INT64_MAX && n >= -INT64_MAX && d <= INT64_MAX;
+}
+
+/* rn/rd = an/ad + bn/bd for canonical inline fractions; false if the result does not fit inline */
+static bool addSmall(int64_t an, int64_t ad, int64_t bn, int64_t bd, int64_t& rn, int64_t& rd)
+{
+   if( ad == 1 && bd == 1 )
+   {
+      rd = 1;
+      return !__builtin_add_overflow(an, bn, &rn) && rn != INT64_MIN;
+   }
+   /* reduce as in Knuth, TAOCP vol. 2, 4.5.1: with g = gcd(ad, bd) and
+    * t = an * (bd/g) + bn * (ad/g), the reduced sum is (t/g2) / ((ad/g) * (bd/g2)), g2 = gcd(t, g) */
+   uint64_t g = gcd(ad, bd);
+   __int128 t = (__int128)an * (int64_t)(bd / g) + (__int128)bn * (int64_t)(ad / g);
+   if( t == 0 )
+   {
+      rn = 0;
+      rd = 1;
+      return true;
+   }
+   uint64_t g2 = 1;
+   if( g > 1 )
+   {
+      unsigned __int128 abst = (t < 0 ? -t : t);
+      g2 = gcd((uint64_t)(abst % g), g);
+   }
+   __int128 n = t / (__int128)g2;
+   __int128 d = (__int128)(ad / g) * (__int128)(bd / g2);
+   if( !fitsSmall(n, d) )
+      return false;
+   rn = (int64_t)n;
+   rd = (int64_t)d;
+   return true;
+}
+
+/* rn/rd = an/ad * bn/bd for canonical inline fractions; false if the result does not fit inline */
+static bool multSmall(int64_t an, int64_t ad, int64_t bn, int64_t bd, int64_t& rn, int64_t& rd)
+{
+   if( an == 0 || bn == 0 )
+   {
+      rn = 0;
+      rd = 1;
+      return true;
+   }
+   /* cross-reduce first, so the product is canonical */
+   int64_t g1 = (bd == 1 ? 1 : gcd(uabs(an), bd));
+   int64_t g2 = (ad == 1 ? 1 : gcd(uabs(bn), ad));
+   return !__builtin_mul_overflow(an / g1, bn / g2, &rn) && rn != INT64_MIN
+      && !__builtin_mul_overflow(ad / g2, bd / g1, &rd);
 }
 
-Rational::Rational(const Rational& val)
+Rational::Rational(int _num, int _den):big(NULL)
 {
-   mpq_init(number);
-   mpq_set(number, val.number);
+   assert( _den != 0 );
+   int64_t n = _num;
+   int64_t d = _den;
+   if( d < 0 )
+   {
+      n = -n;
+      d = -d;
+   }
+   int64_t g = gcd(uabs(n), d);
+   setSmall(n / g, d / g);
+}
+
+Rational::Rational(double frac):num(0), den(1), big(NULL)
+{
+   if( frac == floor(frac) && fabs(frac) < 9.2e18 )
+      setSmall((int64_t)frac, 1);
+   else
+   {
+      mpq_set_d(promote(), frac);
+      demote();
+   }
+}
+
+Rational::Rational(const Rational& val):num(val.num), den(val.den), big(NULL)
+{
+   if( val.isBig() )
+      mpq_set(promote(), val.big);
 }
 
 Rational::~Rational()
 {
-   mpq_clear(number);
+   if( big != NULL )
+   {
+      mpq_clear(big);
+      delete big;
+   }
 }
 
 Rational& Rational::operator=(const Rational& val)
 {
-   if (this != &val)
-      mpq_set(number, val.number);
+   if( this == &val )
+      return *this;
+   if( val.isBig() )
+      mpq_set(promote(), val.big);
+   else
+      setSmall(val.num, val.den);
    return *this;
 }
 
+mpq_ptr Rational::promote()
+{
+   if( big == NULL )
+   {
+      big = new __mpq_struct;
+      mpq_init(big);
+   }
+   den = 0;
+   return big;
+}
+
+void Rational::demote()
+{
+   if( !isBig() || !mpz_fits_slong_p(mpq_numref(big)) || !mpz_fits_slong_p(mpq_denref(big)) )
+      return;
+   long n = mpz_get_si(mpq_numref(big));
+   if( n == LONG_MIN )
+      return;
+   setSmall(n, mpz_get_si(mpq_denref(big)));
+}
+
+mpq_srcptr Rational::view(mpq_ptr res, mp_limb_t* limbs) const
+{
+   if( isBig() )
+      return big;
+   limbs[0] = uabs(num);
+   limbs[1] = den;
+   mpz_roinit_n(mpq_numref(res), &limbs[0], num < 0 ? -1 : (num > 0 ? 1 : 0));
+   mpz_roinit_n(mpq_denref(res), &limbs[1], 1);
+   return res;
+}
+
+int Rational::compare(const Rational& val) const
+{
+   if( !isBig() && !val.isBig() )
+   {
+      if( den == val.den )
+         return (num > val.num) - (num < val.num);
+      __int128 lhs = (__int128)num * val.den;
+      __int128 rhs = (__int128)val.num * den;
+      return (lhs > rhs) - (lhs < rhs);
+   }
+   mpq_t v1;
+   mpq_t v2;
+   mp_limb_t l1[2];
+   mp_limb_t l2[2];
+   return mpq_cmp(view(v1, l1), val.view(v2, l2));
+}
+
 double Rational::toDouble() const
 {
-   return mpq_get_d(number);
+   /* inline values with both parts exact in double: divide, and round the
+    * quotient toward zero (as mpq_get_d does) using the exact remainder */
+   const int64_t exact = (int64_t)1 << 53;
+   if( !isBig() && num < exact && num > -exact && den < exact )
+   {
+      double q = (double)num / (double)den;
+      if( den == 1 )
+         return q;
+      double r = fma(-q, (double)den, (double)num);
+      if( (num > 0 && r < 0.0) || (num < 0 && r > 0.0) )
+         q = nextafter(q, 0.0);
+      return q;
+   }
+   mpq_t v;
+   mp_limb_t l[2];
+   return mpq_get_d(view(v, l));
+}
+
+double Rational::toDouble(int& direction) const
+{
+   direction = 0;
+   const int64_t exact = (int64_t)1 << 53;
+   if( !isBig() && num < exact && num > -exact && den < exact )
+   {
+      double q = (double)num / (double)den;
+      if( den == 1 )
+         return q;
+      double r = fma(-q, (double)den, (double)num);
+      if( r == 0.0 )
+         return q;
+      direction = (num > 0 ? 1 : -1);
+      if( (num > 0 && r < 0.0) || (num < 0 && r > 0.0) )
+         q = nextafter(q, 0.0);
+      return q;
+   }
+   /* compare the truncated value with the exact one */
+   mpq_t v;
+   mp_limb_t l[2];
+   mpq_srcptr value = view(v, l);
+   double q = mpq_get_d(value);
+   if( !isfinite(q) )
+      q = (q > 0.0 ? DBL_MAX : -DBL_MAX);
+   mpq_t rounded;
+   mpq_init(rounded);
+   mpq_set_d(rounded, q);
+   direction = mpq_cmp(value, rounded);
+   direction = (direction > 0) - (direction < 0);
+   mpq_clear(rounded);
+   return q;
 }
 
 bool Rational::operator==(const Rational& val) const
 {
-   return (mpq_equal(number, val.number) != 0);
+   /* values are held in GMP only if they do not fit inline */
+   if( isBig() != val.isBig() )
+      return false;
+   if( !isBig() )
+      return num == val.num && den == val.den;
+   return (mpq_equal(big, val.big) != 0);
 }
 
 bool Rational::operator!=(const Rational& val) const
 {
-   return (mpq_equal(number, val.number) == 0);
+   return !(*this == val);
 }
 
 bool Rational::operator>(const Rational& val) const
 {
-   return (mpq_cmp(number, val.number) > 0);
+   return compare(val) > 0;
 }
 
 bool Rational::operator<(const Rational& val) const
 {
-   return (mpq_cmp(number, val.number) < 0);
+   return compare(val) < 0;
 }
 
 Rational& Rational::operator+=(const Rational& val)
 {
-   mpq_add(number, number, val.number);
-   mpq_canonicalize(number);
+   add(*this, *this, val);
    return *this;
 }
 
 Rational& Rational::operator-=(const Rational& val)
 {
-   mpq_sub(number, number, val.number);
-   mpq_canonicalize(number);
+   sub(*this, *this, val);
    return *this;
 }
 
 Rational& Rational::operator*=(const Rational& val)
 {
-   mpq_mul(number, number, val.number);
-   mpq_canonicalize(number);
+   mult(*this, *this, val);
    return *this;
 }
 
 void Rational::addProduct(const Rational& val1, const Rational& val2)
 {
-   mpq_t prod;
-   mpq_init(prod);
-   mpq_mul(prod, val1.number, val2.number);
-   mpq_add(number, number, prod);
-   mpq_canonicalize(number);
-   mpq_clear(prod);
+   Rational prod;
+   mult(prod, val1, val2);
+   add(*this, *this, prod);
 }
 
 void Rational::abs()
 {
-   mpq_abs(number, number);
+   if( isBig() )
+      mpq_abs(big, big);
+   else if( num < 0 )
+      num = -num;
 }
 
 void Rational::integralityViolation(Rational& violation) const
 {
+   if( !isBig() )
+   {
+      // if denominator is 1, then there is no integrality violation for sure
+      if( den == 1 )
+      {
+         violation.toZero();
+         return;
+      }
+      // distance of the fractional part to the nearest integer (coprime to den, as num is)
+      uint64_t r = uabs(num) % den;
+      if( 2 * r > (uint64_t)den )
+         r = den - r;
+      violation.setSmall(r, den);
+      return;
+   }
    // if denominator is 1, then there is no integrality violation for sure
-   if( mpz_cmp_ui(mpq_denref(number), 1) == 0 )
+   if( mpz_cmp_ui(mpq_denref(big), 1) == 0 )
    {
       violation.toZero();
       return;
@@ -117,9 +329,10 @@ void Rational::integralityViolation(Rational& violation) const
    violation.abs();
    mpz_t r;
    mpz_init(r);
-   mpz_fdiv_r(r, mpq_numref(violation.number), mpq_denref(violation.number));
-   mpq_set_num(violation.number, r);
+   mpz_fdiv_r(r, mpq_numref(violation.big), mpq_denref(violation.big));
+   mpq_set_num(violation.big, r);
    mpz_clear(r);
+   violation.demote();
    // then integrality violation
    if( violation > Rational(1, 2) )
       sub(violation, Rational(1,1), violation);
@@ -127,52 +340,106 @@ void Rational::integralityViolation(Rational& violation) const
 
 void Rational::toZero()
 {
-   mpq_set_ui(number, 0, 1);
+   setSmall(0, 1);
 }
 
 bool Rational::isInteger(const Rational& tolerance) const
 {
    // if denominator is 1, then it is an integer for sure
-   if (mpz_cmp_ui(mpq_denref(number), 1) == 0) return true;
+   if( den == 1 )
+      return true;
    // otherwise, we must check w.r.t. the given tolerance
-   // first calculate the fractional part
-   Rational viol(*this);
-   viol.abs();
-   mpz_t r;
-   mpz_init(r);
-   mpz_fdiv_r(r, mpq_numref(viol.number), mpq_denref(viol.number));
-   mpq_set_num(viol.number, r);
-   mpz_clear(r);
-   // then integrality violation
-   if( viol > Rational(1, 2) )
-      sub(viol, Rational(1,1), viol);
+   Rational viol;
+   integralityViolation(viol);
    return !(viol > tolerance);
 }
 
 bool Rational::isPositive() const
 {
-   return (mpq_sgn(number) > 0);
+   return isBig() ? (mpq_sgn(big) > 0) : (num > 0);
 }
 
 bool Rational::isNegative() const
 {
-   return (mpq_sgn(number) < 0);
+   return isBig() ? (mpq_sgn(big) < 0) : (num < 0);
 }
 
 bool Rational::isZero() const
 {
-   return (mpq_sgn(number) == 0);
+   return !isBig() && num == 0;
+}
+
+/* number of decimal digits that always fit in a chunk (an unsigned 64-bit integer) */
+#define CHUNK_DIGITS      19
+/* powers of ten cached as GMP integers */
+#define POW10_CACHED      64
+
+/* powers of ten that fit in an unsigned 64-bit integer */
+static const uint64_t smallPow10[CHUNK_DIGITS + 1] =
+{
+   1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+   100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+   10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+   100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/* table of 10^k as GMP integers, for k < POW10_CACHED */
+class PowersOfTen
+{
+   public:
+      mpz_t pow[POW10_CACHED];
+
+      PowersOfTen()
+      {
+         mpz_init_set_ui(pow[0], 1);
+         for( int k = 1; k < POW10_CACHED; ++k )
+         {
+            mpz_init(pow[k]);
+            mpz_mul_ui(pow[k], pow[k - 1], 10);
+         }
+      }
+
+      ~PowersOfTen()
+      {
+         for( int k = 0; k < POW10_CACHED; ++k )
+            mpz_clear(pow[k]);
+      }
+};
+
+/* the table is built on first use (thread-safe) and only read afterwards */
+static const PowersOfTen& powersOfTen()
+{
+   static PowersOfTen table;
+   return table;
+}
+
+/* res = val * 10^k */
+static void mulPow10(mpz_ptr res, mpz_srcptr val, int k)
+{
+   if( k < POW10_CACHED )
+      mpz_mul(res, val, powersOfTen().pow[k]);
+   else
+   {
+      mpz_t pow;
+      mpz_init(pow);
+      mpz_ui_pow_ui(pow, 10, k);
+      mpz_mul(res, val, pow);
+      mpz_clear(pow);
+   }
 }
 
 void Rational::fromString(const char* num)
 {
-   char* tmp = &buffer[0];
-   int k = 0;
+   bool negative = false;
    int exponent = 0;
    int fraction = 0;
+   /* the digits are collected in chunks that fit in a machine integer;
+    * only mantissas longer than one chunk are accumulated in the GMP numerator */
+   uint64_t chunk = 0;
+   int chunkDigits = 0;
+   bool isLong = false;
 
    assert(num != NULL);
-   assert(strlen(num) <  32);
 
    // Skip initial whitespace
    while(isspace(*num))
@@ -182,13 +449,31 @@ void Rational::fromString(const char* num)
    if (*num == '+')
       num++;
    else if (*num == '-')
-      tmp[k++] = *num++;
+   {
+      negative = true;
+      num++;
+   }
 
    for(int i = 0; num[i] != '\0'; i++)
    {
-      if (isdigit(num[i]))
+      if (num[i] >= '0' && num[i] <= '9')
       {
-         tmp[k++]  = num[i];
+         if( chunkDigits == CHUNK_DIGITS )
+         {
+            mpz_ptr numer = mpq_numref(promote());
+            if( isLong )
+            {
+               mpz_mul_ui(numer, numer, smallPow10[CHUNK_DIGITS]);
+               mpz_add_ui(numer, numer, chunk);
+            }
+            else
+               mpz_set_ui(numer, chunk);
+            isLong = true;
+            chunk = 0;
+            chunkDigits = 0;
+         }
+         chunk = 10 * chunk + (num[i] - '0');
+         chunkDigits++;
          exponent -= fraction;
       }
       else if (num[i] == '.')
@@ -199,61 +484,208 @@ void Rational::fromString(const char* num)
          break;
       }
    }
-   while(exponent > 0)
+
+   if( !isLong && exponent <= 0 && -exponent <= CHUNK_DIGITS )
    {
-      tmp[k++] = '0';
-      exponent--;
+      /* the fraction is chunk / 10^-exponent, reduce it in machine integers */
+      uint64_t d = smallPow10[-exponent];
+      uint64_t div = gcd(chunk, d);
+      uint64_t n = chunk / div;
+      d /= div;
+      if( n <= INT64_MAX && d <= INT64_MAX )
+      {
+         setSmall(negative ? -(int64_t)n : (int64_t)n, d);
+         return;
+      }
+      mpz_set_ui(mpq_numref(promote()), n);
+      mpz_set_ui(mpq_denref(big), d);
    }
-   tmp[k++] = '/';
-   tmp[k++] = '1';
+   else
+   {
+      mpq_ptr res = promote();
+      if( isLong )
+      {
+         mpz_mul_ui(mpq_numref(res), mpq_numref(res), smallPow10[chunkDigits]);
+         mpz_add_ui(mpq_numref(res), mpq_numref(res), chunk);
+      }
+      else
+         mpz_set_ui(mpq_numref(res), chunk);
+      mpz_set_ui(mpq_denref(res), 1);
+      if( exponent > 0 )
+         mulPow10(mpq_numref(res), mpq_numref(res), exponent);
+      else if( exponent < 0 )
+      {
+         mulPow10(mpq_denref(res), mpq_denref(res), -exponent);
+         mpq_canonicalize(res);
+      }
+   }
+   if( negative )
+      mpz_neg(mpq_numref(big), mpq_numref(big));
+   demote();
+}
 
-   while(exponent < 0)
+std::string Rational::toString() const
+{
+   if( !isBig() )
    {
-      tmp[k++] = '0';
-      exponent++;
+      char buffer[48];
+      if( den == 1 )
+         snprintf(buffer, sizeof(buffer), "%lld", (long long)num);
+      else
+         snprintf(buffer, sizeof(buffer), "%lld/%lld", (long long)num, (long long)den);
+      return std::string(buffer);
    }
-   tmp[k] = '\0';
 
-   mpq_set_str(number, tmp, 10);
-   mpq_canonicalize(number);
+   // size needed by mpq_get_str: digits of both parts, sign, '/' and '\0'
+   std::vector<char> buffer(mpz_sizeinbase(mpq_numref(big), 10) + mpz_sizeinbase(mpq_denref(big), 10) + 3);
+
+   mpq_get_str(&buffer[0], 10, big);
+   return std::string(&buffer[0]);
 }
 
-std::string Rational::toString() const
+void Rational::limbSizes(int& numSize, int& denSize) const
 {
-   // assure the buffer is big enough to store the result
-   assert( mpz_sizeinbase(mpq_numref(number), 10 ) + mpz_sizeinbase(mpq_denref(number), 10) + 3 < 1024 );
+   if( !isBig() )
+   {
+      numSize = (num < 0 ? -1 : (num > 0 ? 1 : 0));
+      denSize = 1;
+      return;
+   }
+   numSize = mpz_size(mpq_numref(big));
+   if( mpz_sgn(mpq_numref(big)) < 0 )
+      numSize = -numSize;
+   denSize = mpz_size(mpq_denref(big));
+}
 
-   mpq_get_str(buffer, 10, number);
-   return std::string(buffer);
+void Rational::toLimbs(mp_limb_t* limbs) const
+{
+   mpq_t v;
+   mp_limb_t l[2];
+   mpq_srcptr val = view(v, l);
+   size_t numLimbs = mpz_size(mpq_numref(val));
+   size_t denLimbs = mpz_size(mpq_denref(val));
+   memcpy(limbs, mpz_limbs_read(mpq_numref(val)), numLimbs * sizeof(mp_limb_t));
+   memcpy(limbs + numLimbs, mpz_limbs_read(mpq_denref(val)), denLimbs * sizeof(mp_limb_t));
+}
+
+void Rational::fromLimbs(int numSize, int denSize, const mp_limb_t* limbs)
+{
+   int numLimbs = numSize < 0 ? -numSize : numSize;
+   assert( denSize > 0 );
+   if( numLimbs <= 1 && denSize == 1 && limbs[numLimbs] <= (mp_limb_t)INT64_MAX
+      && (numLimbs == 0 || limbs[0] <= (mp_limb_t)INT64_MAX) )
+   {
+      int64_t n = (numLimbs == 0 ? 0 : (int64_t)limbs[0]);
+      setSmall(numSize < 0 ? -n : n, limbs[numLimbs]);
+      return;
+   }
+   mpq_ptr res = promote();
+   if( numLimbs == 0 )
+      mpz_set_ui(mpq_numref(res), 0);
+   else
+   {
+      memcpy(mpz_limbs_write(mpq_numref(res), numLimbs), limbs, numLimbs * sizeof(mp_limb_t));
+      mpz_limbs_finish(mpq_numref(res), numSize);
+   }
+   memcpy(mpz_limbs_write(mpq_denref(res), denSize), limbs + numLimbs, denSize * sizeof(mp_limb_t));
+   mpz_limbs_finish(mpq_denref(res), denSize);
+   demote();
 }
 
 void add(Rational& res, const Rational& val1, const Rational& val2)
 {
-   mpq_add(res.number, val1.number, val2.number);
-   mpq_canonicalize(res.number);
+   if( !val1.isBig() && !val2.isBig() )
+   {
+      int64_t n;
+      int64_t d;
+      if( addSmall(val1.num, val1.den, val2.num, val2.den, n, d) )
+      {
+         res.setSmall(n, d);
+         return;
+      }
+   }
+   mpq_t v1;
+   mpq_t v2;
+   mp_limb_t l1[2];
+   mp_limb_t l2[2];
+   mpq_srcptr p1 = val1.view(v1, l1);
+   mpq_srcptr p2 = val2.view(v2, l2);
+   mpq_add(res.promote(), p1, p2);
+   res.demote();
 }
 
 void sub(Rational& res, const Rational& val1, const Rational& val2)
 {
-   mpq_sub(res.number, val1.number, val2.number);
-   mpq_canonicalize(res.number);
+   if( !val1.isBig() && !val2.isBig() )
+   {
+      int64_t n;
+      int64_t d;
+      if( addSmall(val1.num, val1.den, -val2.num, val2.den, n, d) )
+      {
+         res.setSmall(n, d);
+         return;
+      }
+   }
+   mpq_t v1;
+   mpq_t v2;
+   mp_limb_t l1[2];
+   mp_limb_t l2[2];
+   mpq_srcptr p1 = val1.view(v1, l1);
+   mpq_srcptr p2 = val2.view(v2, l2);
+   mpq_sub(res.promote(), p1, p2);
+   res.demote();
 }
 
 void mult(Rational& res, const Rational& val1, const Rational& val2)
 {
-   mpq_mul(res.number, val1.number, val2.number);
-   mpq_canonicalize(res.number);
+   if( !val1.isBig() && !val2.isBig() )
+   {
+      int64_t n;
+      int64_t d;
+      if( multSmall(val1.num, val1.den, val2.num, val2.den, n, d) )
+      {
+         res.setSmall(n, d);
+         return;
+      }
+   }
+   mpq_t v1;
+   mpq_t v2;
+   mp_limb_t l1[2];
+   mp_limb_t l2[2];
+   mpq_srcptr p1 = val1.view(v1, l1);
+   mpq_srcptr p2 = val2.view(v2, l2);
+   mpq_mul(res.promote(), p1, p2);
+   res.demote();
 }
 
 void div(Rational& res, const Rational& val1, const Rational& val2)
 {
-   mpq_div(res.number, val1.number, val2.number);
-   mpq_canonicalize(res.number);
+   assert( !val2.isZero() );
+   if( !val1.isBig() && !val2.isBig() )
+   {
+      /* multiply with the reciprocal of val2 */
+      int64_t n;
+      int64_t d;
+      int64_t recnum = (val2.num < 0 ? -val2.den : val2.den);
+      if( multSmall(val1.num, val1.den, recnum, uabs(val2.num), n, d) )
+      {
+         res.setSmall(n, d);
+         return;
+      }
+   }
+   mpq_t v1;
+   mpq_t v2;
+   mp_limb_t l1[2];
+   mp_limb_t l2[2];
+   mpq_srcptr p1 = val1.view(v1, l1);
+   mpq_srcptr p2 = val2.view(v2, l2);
+   mpq_div(res.promote(), p1, p2);
+   res.demote();
 }
 
 void min(Rational& res, const Rational& val1, const Rational& val2)
 {
-   if( mpq_cmp(val1.number, val2.number) < 0 )
+   if( val1.compare(val2) < 0 )
       res = val1;
    else
       res = val2;
@@ -261,7 +693,7 @@ void min(Rational& res, const Rational& val1, const Rational& val2)
 
 void max(Rational& res, const Rational& val1, const Rational& val2)
 {
-   if( mpq_cmp(val1.number, val2.number) > 0 )
+   if( val1.compare(val2) > 0 )
       res = val1;
    else
       res = val2;
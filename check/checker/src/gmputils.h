@@ -7,10 +7,17 @@
 #define GMPUTILS_H
 
 #include <gmp.h>
+#include <stdint.h>
 #include <string>
 
 /**
- * @brief Simple wrapper class around GMP mpq_t.
+ * @brief Exact rational number.
+ * Values whose numerator and denominator fit in 64-bit integers (most data of
+ * MIP models: small integers and short decimals) are stored inline and computed
+ * with machine arithmetic, without any allocation. Only when a result does not fit
+ * the value is promoted to a GMP mpq_t, which is allocated on first use and kept
+ * for later promotions. Results that fit again are demoted, so a value is held in
+ * GMP if and only if it does not fit inline.
  */
 class Rational
 {
@@ -44,6 +51,16 @@ class Rational
        */
       double toDouble() const;
 
+      /**
+       * Convert to a double, truncating as toDouble(), and tell where the value lies
+       * relative to the result (e.g. to build enclosures for interval arithmetic).
+       * A value beyond the double range is rounded to the largest finite double.
+       * @param direction stores 0 if the result is exact, 1 if the value is above it,
+       *        -1 if the value is below it
+       * @return the rational number as a float
+       */
+      double toDouble(int& direction) const;
+
       /** equal operator */
       bool operator==(const Rational& val) const;
 
@@ -123,6 +140,8 @@ class Rational
        * This functions essentially parses a number of the form
        * [+|-]?[0-9]*.[0-9]+[[e|E][+|-][0-9]+]?
        * and generates the corresponding fraction.
+       * The mantissa may have any length; it is converted in machine integers
+       * as long as it fits. A string without digits gives zero.
        */
       void fromString(const char* str);
 
@@ -132,15 +151,50 @@ class Rational
        * Useful for printing.
        */
       std::string toString() const;
-   protected:
-      /* rational value */
-      mpq_t number;
-   private:
+
       /**
-       * static buffer for I/O operations
-       * if a number does not fit in here, it does not fit in a double either
+       * Get the sizes of the raw GMP representation, see toLimbs().
+       * @param numSize stores the number of numerator limbs, negated for negative values
+       * @param denSize stores the number of denominator limbs
        */
-      static char buffer[1024];
+      void limbSizes(int& numSize, int& denSize) const;
+
+      /**
+       * Copy the raw GMP limbs of the value into @param limbs:
+       * the numerator limbs followed by the denominator limbs.
+       */
+      void toLimbs(mp_limb_t* limbs) const;
+
+      /**
+       * Set the value from its raw GMP limbs, as produced by limbSizes() and toLimbs().
+       * The fraction must already be in canonical form.
+       */
+      void fromLimbs(int numSize, int denSize, const mp_limb_t* limbs);
+   protected:
+      /* numerator of the inline value (|num| <= INT64_MAX) */
+      int64_t num;
+      /* denominator of the inline value (den > 0, gcd(num, den) = 1), 0 if the value is held in big */
+      int64_t den;
+      /* GMP value, allocated on the first promotion (NULL before) */
+      mpq_ptr big;
+
+      /** Compare with @param val: negative, zero or positive if smaller, equal or greater */
+      int compare(const Rational& val) const;
+
+      /** Is the value held in big? */
+      bool isBig() const { return den == 0; }
+
+      /** Set the inline value; @param _num and @param _den must be canonical */
+      void setSmall(int64_t _num, int64_t _den) { num = _num; den = _den; }
+
+      /** Allocate big if needed, and mark the value as held in it */
+      mpq_ptr promote();
+
+      /** Move the value back inline if it fits */
+      void demote();
+
+      /** Set @param res to a read-only GMP view of the value, using @param limbs (2 limbs) as storage */
+      mpq_srcptr view(mpq_ptr res, mp_limb_t* limbs) const;
 };
 
 #endif
@@ -0,0 +1,47 @@
+/**
+ * @file hash.h
+ * @brief Fast non-cryptographic hashing, shared by the model cache and the fingerprints
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+
+/* initial value of a hash (the FNV-1a offset basis) */
+#define HASH_SEED         14695981039346656037ULL
+
+/* multiplier of the hash (the FNV-1a prime) */
+#define HASH_PRIME        1099511628211ULL
+
+/** Add the 64-bit value @param value to @param hash; the shift folds high bits back down */
+inline uint64_t hashWord(uint64_t hash, uint64_t value)
+{
+   hash = (hash ^ value) * HASH_PRIME;
+   return hash ^ (hash >> 32);
+}
+
+/**
+ * FNV-1a style hash taking 64-bit words at a time. The words are read little-endian,
+ * so that the hash of the same bytes is the same on every host.
+ */
+inline uint64_t hashBytes(uint64_t hash, const unsigned char* data, size_t len)
+{
+   size_t k = 0;
+   for( ; k + 8 <= len; k += 8 )
+   {
+      uint64_t word;
+      memcpy(&word, data + k, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      word = __builtin_bswap64(word);
+#endif
+      hash = hashWord(hash, word);
+   }
+   for( ; k < len; ++k )
+      hash = (hash ^ data[k]) * HASH_PRIME;
+   return hash;
+}
+
+#endif
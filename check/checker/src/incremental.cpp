@@ -0,0 +1,278 @@
+/**
+ * @file incremental.cpp
+ * @brief Incremental checking of a stream of solutions
+ */
+
+#include "incremental.h"
+#include <assert.h>
+
+IncrementalCheck::IncrementalCheck(Model* _model, const Rational& _intTolerance, const Rational& _linearTolerance)
+   :model(_model), intTolerance(_intTolerance), linearTolerance(_linearTolerance), nBoundFailures(0), nIntFailures(0)
+{
+   assert( model->matrix.isCompressed() );
+   unsigned int nvars = model->numVars();
+   unsigned int nconss = model->numConss();
+
+   /* which constraint depends on which row or (for non-linear constraints) variable */
+   rowCons.assign(model->matrix.numRows(), -1);
+   consRow.assign(nconss, -1);
+   std::vector<int> pairVar;
+   std::vector<int> pairCons;
+   for( unsigned int i = 0; i < nconss; ++i )
+   {
+      const Constraint* cons = model->getCons(i);
+      const LinearConstraint* lincons = dynamic_cast<const LinearConstraint*>(cons);
+      const SOSConstraint* soscons = dynamic_cast<const SOSConstraint*>(cons);
+      const IndicatorConstraint* indcons = dynamic_cast<const IndicatorConstraint*>(cons);
+      if( lincons != NULL )
+      {
+         consRow[i] = lincons->row;
+         rowCons[lincons->row] = i;
+      }
+      else if( soscons != NULL )
+      {
+         for( unsigned int k = 0; k < soscons->vars.size(); ++k )
+         {
+            pairVar.push_back(soscons->vars[k]->index);
+            pairCons.push_back(i);
+         }
+      }
+      else if( indcons != NULL )
+      {
+         pairVar.push_back(indcons->ifvar->index);
+         pairCons.push_back(i);
+         lincons = dynamic_cast<const LinearConstraint*>(indcons->thencons);
+         assert( lincons != NULL );
+         rowCons[lincons->row] = i;
+      }
+   }
+
+   /* non-linear constraints of each variable, by counting sort */
+   varConsBeg.assign(nvars + 1, 0);
+   for( unsigned int k = 0; k < pairVar.size(); ++k )
+      varConsBeg[pairVar[k] + 1]++;
+   for( unsigned int j = 0; j < nvars; ++j )
+      varConsBeg[j + 1] += varConsBeg[j];
+   varConsInd.resize(pairVar.size());
+   std::vector<int> next(varConsBeg.begin(), varConsBeg.end() - 1);
+   for( unsigned int k = 0; k < pairVar.size(); ++k )
+      varConsInd[next[pairVar[k]]++] = pairCons[k];
+
+   reset();
+}
+
+void IncrementalCheck::reset()
+{
+   const SparseMatrix& matrix = model->matrix;
+   const Solution& sol = model->solution;
+   unsigned int nvars = model->numVars();
+   unsigned int nconss = model->numConss();
+   assert( sol.size() == nvars );
+
+   posact.assign(matrix.numRows(), Rational());
+   negact.assign(matrix.numRows(), Rational());
+   varBoundViol.assign(nvars, Rational());
+   varIntViol.assign(nvars, Rational());
+   consViol.assign(nconss, Rational());
+   boundFailed.assign(nvars, 0);
+   intFailed.assign(nvars, 0);
+   nBoundFailures = 0;
+   nIntFailures = 0;
+   failedVars.clear();
+   failedConss.clear();
+   linearViols.clear();
+   intViols.clear();
+   objValPlus.toZero();
+   objValMinus.toZero();
+
+   /* activities and objective value from the nonzero values */
+   const std::vector<unsigned int>& support = sol.support();
+   Rational prod;
+   for( unsigned int s = 0; s < support.size(); ++s )
+   {
+      int col = support[s];
+      const Rational& value = sol[col];
+      if( value.isZero() )
+         continue;
+      addObjective(model->getVar(col), value, 1);
+      for( int k = matrix.colBeg[col]; k < matrix.colBeg[col + 1]; ++k )
+      {
+         int row = matrix.colInd[k];
+         mult(prod, matrix.rowVal[matrix.colPos[k]], value);
+         if( prod.isPositive() )
+            posact[row] += prod;
+         else
+            negact[row] += prod;
+      }
+   }
+
+   /* everything is evaluated by the next evaluate() */
+   dirtyVars.clear();
+   dirtyConss.clear();
+   varDirty.assign(nvars, 0);
+   consDirty.assign(nconss, 0);
+   for( unsigned int j = 0; j < nvars; ++j )
+      markVar(j);
+   for( unsigned int i = 0; i < nconss; ++i )
+      markCons(i);
+}
+
+void IncrementalCheck::set(unsigned int index, const Rational& value)
+{
+   Solution& sol = model->solution;
+   assert( index < sol.size() );
+   if( sol[index] == value )
+      return;
+   Rational oldValue(sol[index]);
+   const Var* var = model->getVar(index);
+   addObjective(var, oldValue, -1);
+   addObjective(var, value, 1);
+
+   /* replace the products of the column in the activities of its rows */
+   const SparseMatrix& matrix = model->matrix;
+   Rational prod;
+   for( int k = matrix.colBeg[index]; k < matrix.colBeg[index + 1]; ++k )
+   {
+      int row = matrix.colInd[k];
+      const Rational& coef = matrix.rowVal[matrix.colPos[k]];
+      if( !oldValue.isZero() )
+      {
+         mult(prod, coef, oldValue);
+         if( prod.isPositive() )
+            posact[row] -= prod;
+         else
+            negact[row] -= prod;
+      }
+      if( !value.isZero() )
+      {
+         mult(prod, coef, value);
+         if( prod.isPositive() )
+            posact[row] += prod;
+         else
+            negact[row] += prod;
+      }
+      if( rowCons[row] >= 0 )
+         markCons(rowCons[row]);
+   }
+   for( int k = varConsBeg[index]; k < varConsBeg[index + 1]; ++k )
+      markCons(varConsInd[k]);
+   markVar(index);
+
+   sol.set(index, value);
+}
+
+void IncrementalCheck::evaluate(CheckResult& result)
+{
+   for( unsigned int k = 0; k < dirtyVars.size(); ++k )
+   {
+      evaluateVar(dirtyVars[k]);
+      varDirty[dirtyVars[k]] = 0;
+   }
+   dirtyVars.clear();
+   for( unsigned int k = 0; k < dirtyConss.size(); ++k )
+   {
+      evaluateCons(dirtyConss[k]);
+      consDirty[dirtyConss[k]] = 0;
+   }
+   dirtyConss.clear();
+
+   result = CheckResult();
+   result.intFeasible = (nIntFailures == 0);
+   result.linearFeasible = (nBoundFailures == 0 && failedConss.empty());
+   if( !failedVars.empty() )
+      result.firstVarFailure = *failedVars.begin();
+   if( !failedConss.empty() )
+      result.firstConsFailure = *failedConss.begin();
+   if( !intViols.empty() )
+      result.intViol = *intViols.rbegin();
+   if( !linearViols.empty() )
+      result.linearViol = *linearViols.rbegin();
+   model->checkObjective(objValPlus, objValMinus, model->hasObjectiveValue ? &model->objectiveValue : NULL, linearTolerance, result);
+}
+
+void IncrementalCheck::markVar(int index)
+{
+   if( varDirty[index] )
+      return;
+   varDirty[index] = 1;
+   dirtyVars.push_back(index);
+}
+
+void IncrementalCheck::markCons(int index)
+{
+   if( consDirty[index] )
+      return;
+   consDirty[index] = 1;
+   dirtyConss.push_back(index);
+}
+
+void IncrementalCheck::addObjective(const Var* var, const Rational& value, int sign)
+{
+   if( value.isZero() || var->objCoef.isZero() )
+      return;
+   Rational prod;
+   mult(prod, var->objCoef, value);
+   Rational& sum = (prod.isPositive() ? objValPlus : objValMinus);
+   if( sign > 0 )
+      sum += prod;
+   else
+      sum -= prod;
+}
+
+void IncrementalCheck::updateViolations(std::multiset<Rational>& viols, const Rational& viol, int sign)
+{
+   if( viol.isZero() )
+      return;
+   if( sign > 0 )
+      viols.insert(viol);
+   else
+   {
+      std::multiset<Rational>::iterator itr = viols.find(viol);
+      assert( itr != viols.end() );
+      viols.erase(itr);
+   }
+}
+
+void IncrementalCheck::evaluateVar(int index)
+{
+   const Var* var = model->getVar(index);
+   const Rational& value = model->solution[index];
+   updateViolations(linearViols, varBoundViol[index], -1);
+   updateViolations(intViols, varIntViol[index], -1);
+
+   /* same checks as in Model::evaluate() */
+   var->boundsViolation(value, varBoundViol[index]);
+   bool boundFail = !varBoundViol[index].isZero() && !var->withinRelaxedBounds(value, linearTolerance);
+   var->integralityViolation(value, varIntViol[index]);
+   bool intFail = (varIntViol[index] > intTolerance);
+
+   updateViolations(linearViols, varBoundViol[index], 1);
+   updateViolations(intViols, varIntViol[index], 1);
+   nBoundFailures += (int)boundFail - boundFailed[index];
+   nIntFailures += (int)intFail - intFailed[index];
+   boundFailed[index] = boundFail;
+   intFailed[index] = intFail;
+   if( boundFail || intFail )
+      failedVars.insert(index);
+   else
+      failedVars.erase(index);
+}
+
+void IncrementalCheck::evaluateCons(int index)
+{
+   updateViolations(linearViols, consViol[index], -1);
+   bool feasible;
+   int row = consRow[index];
+   if( row >= 0 )
+   {
+      const LinearConstraint* lincons = static_cast<const LinearConstraint*>(model->getCons(index));
+      feasible = lincons->evaluateActivity(posact[row], negact[row], linearTolerance, consViol[index]);
+   }
+   else
+      feasible = model->getCons(index)->evaluate(model->solution, linearTolerance, consViol[index]);
+   updateViolations(linearViols, consViol[index], 1);
+   if( feasible )
+      failedConss.erase(index);
+   else
+      failedConss.insert(index);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file incremental.h
+ * @brief Incremental checking of a stream of solutions
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "model.h"
+#include <set>
+#include <vector>
+
+/**
+ * @brief Checks a stream of solutions of a model that differ from each other in a few values,
+ * such as the incumbents found by a heuristic.
+ * The exact activity of every row and the violations of every variable and constraint are
+ * cached, so that after changing some values with set() only the variables changed and the
+ * constraints containing them are evaluated again. The cost of a check is thus proportional
+ * to the nonzeros in the columns of the changed variables, not to the size of the model.
+ * Verdicts and violations are the same as the ones of Model::evaluate() on the same solution.
+ * The solution is kept in the model (see Model::solution), which must not be changed otherwise.
+ */
+class IncrementalCheck
+{
+   public:
+      /**
+       * Constructor. Checks the current solution of the model from scratch.
+       * @param _model finalized model
+       * @param _intTolerance tolerance for integrality check
+       * @param _linearTolerance tolerance for constraint (and bound) checks and objective value
+       */
+      IncrementalCheck(Model* _model, const Rational& _intTolerance, const Rational& _linearTolerance);
+
+      /**
+       * Check the current solution of the model from scratch, e.g. after it was read with
+       * Model::readSol(). All cached state is computed again.
+       */
+      void reset();
+
+      /**
+       * Change the value of a variable in the solution of the model.
+       * Row activities are updated right away; verdicts are updated by evaluate().
+       * @param index position of the variable
+       * @param value new value
+       */
+      void set(unsigned int index, const Rational& value);
+
+      /**
+       * Get the verdicts and violations of the current solution, evaluating again only what
+       * changed since the last call. The objective value given by the solver is taken from
+       * the model (see Model::objectiveValue) on each call.
+       * @param result stores verdicts and violations
+       */
+      void evaluate(CheckResult& result);
+
+   protected:
+      /* model checked */
+      Model* model;
+      /* tolerance for integrality check */
+      Rational intTolerance;
+      /* tolerance for constraint (and bound) checks and objective value */
+      Rational linearTolerance;
+
+      /* exact positive part of the activity of each row */
+      std::vector<Rational> posact;
+      /* exact negative part of the activity of each row */
+      std::vector<Rational> negact;
+      /* constraint to evaluate when the activity of a row changes (-1 if none) */
+      std::vector<int> rowCons;
+      /* row of each constraint (-1 if not a linear constraint) */
+      std::vector<int> consRow;
+      /* start of the list of the non-linear constraints of each variable in varConsInd (size numVars() + 1) */
+      std::vector<int> varConsBeg;
+      /* non-linear constraints of each variable (SOS members and indicator premises) */
+      std::vector<int> varConsInd;
+
+      /* bound violation of each variable */
+      std::vector<Rational> varBoundViol;
+      /* integrality violation of each variable */
+      std::vector<Rational> varIntViol;
+      /* violation of each constraint */
+      std::vector<Rational> consViol;
+      /* does the variable fail its bounds check? */
+      std::vector<char> boundFailed;
+      /* does the variable fail its integrality check? */
+      std::vector<char> intFailed;
+      /* number of variables failing their bounds check */
+      int nBoundFailures;
+      /* number of variables failing their integrality check */
+      int nIntFailures;
+      /* positions of the variables failing their bounds or integrality check */
+      std::set<int> failedVars;
+      /* positions of the constraints failing their check */
+      std::set<int> failedConss;
+      /* nonzero bound and constraint violations */
+      std::multiset<Rational> linearViols;
+      /* nonzero integrality violations */
+      std::multiset<Rational> intViols;
+      /* sum of the positive terms of the objective function */
+      Rational objValPlus;
+      /* sum of the negative terms of the objective function */
+      Rational objValMinus;
+
+      /* variables changed since the last evaluate() */
+      std::vector<int> dirtyVars;
+      /* constraints to evaluate again in the next evaluate() */
+      std::vector<int> dirtyConss;
+      /* is the variable in dirtyVars? */
+      std::vector<char> varDirty;
+      /* is the constraint in dirtyConss? */
+      std::vector<char> consDirty;
+
+      /** Mark a variable to be evaluated again */
+      void markVar(int index);
+
+      /** Mark a constraint to be evaluated again */
+      void markCons(int index);
+
+      /** Add the term of the objective function of a variable with value @param value, with sign @param sign */
+      void addObjective(const Var* var, const Rational& value, int sign);
+
+      /** Add @param viol to the nonzero violations @param viols, or remove it if @param sign is negative */
+      static void updateViolations(std::multiset<Rational>& viols, const Rational& viol, int sign);
+
+      /** Evaluate a variable again and update the cached state */
+      void evaluateVar(int index);
+
+      /** Evaluate a constraint again and update the cached state */
+      void evaluateCons(int index);
+};
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file interval.h
+ * @brief Outward-rounded double intervals for the interval checking backend
+ */
+
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include <fenv.h>
+#include <math.h>
+#include <algorithm>
+
+/**
+ * @brief Sets the rounding mode of the calling thread to upward while in scope.
+ * The interval operations below are only outward-rounded under this mode: an upper
+ * bound is computed directly, a lower bound as the negated upper bound of the negated
+ * expression, so that a single rounding mode serves both ends.
+ * The previous mode is restored on destruction; nothing else (in particular no output
+ * of doubles) should be done in the scope.
+ */
+class RoundUpward
+{
+   public:
+      RoundUpward():saved(fegetround()) { fesetround(FE_UPWARD); }
+      ~RoundUpward() { fesetround(saved); }
+   protected:
+      int saved;
+};
+
+/**
+ * @brief Closed interval [lo, hi] of doubles enclosing an exact value.
+ * Enclosures are built from values truncated to double (see Rational::toDouble(int&))
+ * and combined with the operations below under RoundUpward, so that the exact result
+ * of an expression is always within the interval computed for it.
+ * Operations producing NaN (e.g. zero times an infinite bound) give the whole line.
+ */
+class Interval
+{
+   public:
+      double lo;
+      double hi;
+
+      /** Constructor for the point zero */
+      Interval():lo(0.0), hi(0.0) {}
+
+      /** Constructor for the point @param value */
+      Interval(double value):lo(value), hi(value) {}
+
+      /** Constructor for [@param _lo, @param _hi] */
+      Interval(double _lo, double _hi):lo(_lo), hi(_hi) {}
+
+      /**
+       * Enclosure of a value truncated to @param approx, lying in @param direction from it
+       * (0 if exact, 1 if above, -1 if below, as given by Rational::toDouble(int&))
+       */
+      static Interval enclose(double approx, int direction)
+      {
+         if( direction == 0 )
+            return Interval(approx);
+         if( direction > 0 )
+            return Interval(approx, nextafter(approx, INFINITY));
+         return Interval(nextafter(approx, -INFINITY), approx);
+      }
+};
+
+inline Interval operator+(const Interval& a, const Interval& b)
+{
+   return Interval(-(-a.lo - b.lo), a.hi + b.hi);
+}
+
+inline Interval operator-(const Interval& a, const Interval& b)
+{
+   return Interval(-(b.hi - a.lo), a.hi - b.lo);
+}
+
+inline Interval operator-(const Interval& a)
+{
+   return Interval(-a.hi, -a.lo);
+}
+
+inline Interval operator*(const Interval& a, const Interval& b)
+{
+   Interval res;
+   if( a.lo == a.hi && b.lo == b.hi )
+   {
+      /* most data is exact in double: a single product */
+      res.hi = a.hi * b.hi;
+      res.lo = -(-a.lo * b.lo);
+   }
+   else
+   {
+      /* the extreme products are among those of the ends */
+      res.hi = std::max(std::max(a.lo * b.lo, a.lo * b.hi), std::max(a.hi * b.lo, a.hi * b.hi));
+      res.lo = -std::max(std::max(-a.lo * b.lo, -a.lo * b.hi), std::max(-a.hi * b.lo, -a.hi * b.hi));
+      if( isnan(a.lo * b.lo) || isnan(a.lo * b.hi) || isnan(a.hi * b.lo) || isnan(a.hi * b.hi) )
+         return Interval(-INFINITY, INFINITY);
+   }
+   if( isnan(res.hi) )
+      return Interval(-INFINITY, INFINITY);
+   return res;
+}
+
+/** Enclosure of max {a, b} for all values in @param a and @param b */
+inline Interval max(const Interval& a, const Interval& b)
+{
+   return Interval(std::max(a.lo, b.lo), std::max(a.hi, b.hi));
+}
+
+/** Enclosure of |a| for all values in @param a */
+inline Interval abs(const Interval& a)
+{
+   if( a.lo >= 0.0 )
+      return a;
+   if( a.hi <= 0.0 )
+      return -a;
+   return Interval(0.0, std::max(-a.lo, a.hi));
+}
+
+/** Enclosure of max {a, 0} for all values in @param a */
+inline Interval positivePart(const Interval& a)
+{
+   return Interval(std::max(a.lo, 0.0), std::max(a.hi, 0.0));
+}
+
+/** Enclosure of min {a, 0} for all values in @param a */
+inline Interval negativePart(const Interval& a)
+{
+   return Interval(std::min(a.lo, 0.0), std::min(a.hi, 0.0));
+}
+
+#endif
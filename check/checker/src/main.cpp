@@ -6,74 +6,548 @@
 
 #include "model.h"
 #include "mpsinput.h"
+#include "modelcache.h"
+#include "fingerprint.h"
+#include "server.h"
 #include "gmputils.h"
+#include "parallel.h"
+#include "profile.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 
-int main (int argc, char const *argv[])
+/**
+ * Collect the solution files given by @param path: the path itself if it is a file,
+ * or the files ending in ".sol" (in name order) if it is a directory.
+ * @return false if the path cannot be read
+ */
+static bool collectSolutions(const char* path, std::vector<std::string>& files)
 {
-   if( argc < 3 || argc > 5 )
+   struct stat st;
+   if( stat(path, &st) != 0 )
    {
-      printf("Usage: solchecker filename.mps[.gz] solution.sol [linear_tol int_tol]\n");
-      return 0;
+      printf("cannot access <%s>\n", path);
+      return false;
+   }
+   if( !S_ISDIR(st.st_mode) )
+   {
+      files.push_back(path);
+      return true;
    }
 
-   /* read model */
+   DIR* dir = opendir(path);
+   if( dir == NULL )
+   {
+      printf("cannot open directory <%s>\n", path);
+      return false;
+   }
+   std::vector<std::string> names;
+   struct dirent* entry;
+   while( (entry = readdir(dir)) != NULL )
+   {
+      size_t len = strlen(entry->d_name);
+      if( len > 4 && !strcmp(entry->d_name + len - 4, ".sol") )
+         names.push_back(entry->d_name);
+   }
+   closedir(dir);
+
+   std::sort(names.begin(), names.end());
+   for( unsigned int i = 0; i < names.size(); ++i )
+      files.push_back(std::string(path) + "/" + names[i]);
+   return true;
+}
+
+/**
+ * Check each of the solutions given by @param paths (files or directories) against
+ * the model, printing one result line per solution.
+ */
+static void checkBatch(
+      Model* model,
+      const char* const* paths,
+      int npaths,
+      const Rational& intTolerance,
+      const Rational& linearTolerance,
+      int nthreads)
+{
+   std::vector<std::string> files;
+   for( int i = 0; i < npaths; ++i )
+      collectSolutions(paths[i], files);
+
+   for( unsigned int i = 0; i < files.size(); ++i )
+   {
+      bool success = model->readSol(files[i].c_str());
+      if( !success )
+      {
+         printf("Batch SOL: %s Read 0\n", files[i].c_str());
+         continue;
+      }
+      CheckResult result;
+      model->evaluate(intTolerance, linearTolerance, result, nthreads);
+      printf("Batch SOL: %s Read 1 Integrality %d Constraints %d Objective %d Violations %f %f %f\n",
+            files[i].c_str(), result.intFeasible, result.linearFeasible, result.correctObj,
+            result.intViol.toDouble(), result.linearViol.toDouble(), result.objViol.toDouble());
+   }
+}
+
+/**
+ * Check all solutions of each solution pool file in @param paths against the model,
+ * printing one result line per solution and the best objective value among the feasible
+ * ones. Solutions are checked concurrently: each thread fills its own copy of the solution
+ * values, while the model is shared.
+ */
+static void checkPools(
+      Model* model,
+      const char* const* paths,
+      int npaths,
+      const Rational& intTolerance,
+      const Rational& linearTolerance,
+      int nthreads)
+{
+   for( int i = 0; i < npaths; ++i )
+   {
+      std::vector<PoolSolution> pool;
+      bool success = model->readSolPool(paths[i], pool);
+      printf("Read SOL: %d\n", success);
+      printf("Pool %s has %d solutions\n", paths[i], (int)pool.size());
+      if( !success )
+         continue;
+
+      /* threads are spread over the solutions first, the rest check within a solution */
+      int nouter = std::min(nthreads, (int)pool.size());
+      int ninner = std::max(1, nthreads / nouter);
+      std::vector<CheckResult> results(pool.size());
+      std::vector<Solution> sols(nouter);
+      std::vector<ColumnActivity> scratch(nouter);
+      parallelFor(pool.size(), 1, nouter, [&](unsigned int begin, unsigned int end, int thread)
+      {
+         Solution& sol = sols[thread];
+         sol.resize(model->numVars());
+         for( unsigned int k = begin; k < end; ++k )
+         {
+            pool[k].fill(sol);
+            model->evaluate(sol, pool[k].hasObjectiveValue ? &pool[k].objectiveValue : NULL,
+               intTolerance, linearTolerance, results[k], ninner, scratch[thread]);
+         }
+      });
+
+      int best = -1;
+      for( unsigned int k = 0; k < pool.size(); ++k )
+      {
+         const CheckResult& result = results[k];
+         printf("Pool SOL: %u %s Integrality %d Constraints %d Objective %d Value %f Violations %f %f %f\n",
+               k + 1, pool[k].name.empty() ? "-" : pool[k].name.c_str(),
+               result.intFeasible, result.linearFeasible, result.correctObj, result.objVal.toDouble(),
+               result.intViol.toDouble(), result.linearViol.toDouble(), result.objViol.toDouble());
+         if( !result.intFeasible || !result.linearFeasible )
+            continue;
+         if( best < 0 || (model->objSense == Model::MAXIMIZE ? result.objVal > results[best].objVal : result.objVal < results[best].objVal) )
+            best = k;
+      }
+      if( best >= 0 )
+         printf("Best verified objective: %f (solution %d)\n", results[best].objVal.toDouble(), best + 1);
+      else
+         printf("Best verified objective: none\n");
+   }
+}
+
+/**
+ * Read the model of an MPS file, from the model cache in @param cachedir if possible
+ * (NULL for no cache). A model read from the MPS file is stored in the cache.
+ * @param nthreads number of threads to parse the MPS file with
+ * @param backend arithmetic the model decides its constraints with
+ * @return the model, or NULL if the MPS file cannot be read
+ */
+static Model* readModel(const char* filename, const char* cachedir, int nthreads, Model::Backend backend)
+{
+   ModelCache cache(cachedir != NULL ? cachedir : "");
    Model* model = new Model;
-   MpsInput* mpsi = new MpsInput;
-   bool success = mpsi->readMps(argv[1], model);
+   model->backend = backend;
+   if( cachedir != NULL )
+   {
+      if( cache.load(filename, model) )
+         return model;
+      /* start over, the model may be partially filled */
+      delete model;
+      model = new Model;
+      model->backend = backend;
+   }
+
+   MpsInput mpsi(nthreads);
+   if( !mpsi.readMps(filename, model) )
+   {
+      delete model;
+      return NULL;
+   }
+   if( cachedir != NULL && !cache.store(model) )
+      printf("cannot write model cache in <%s>\n", cachedir);
+   return model;
+}
+
+/**
+ * Check the solution of a model and print the report, once both are read.
+ * @param profile stores the time of the phases of the check (if not NULL)
+ * @param nworst number of largest violations to report per ranking (0 for none)
+ */
+static void reportCheck(
+      Model* model,
+      const Rational& linearTolerance,
+      const Rational& intTolerance,
+      int nthreads,
+      Profile* profile,
+      int nworst)
+{
+   if( !model->hasObjectiveValue )
+      printf("No objective value given\n");
+   printf("\n");
+
+   printf("Integrality tolerance:   %s\n", intTolerance.toString().c_str());
+   printf("Linear tolerance:        %s\n", linearTolerance.toString().c_str());
+   printf("Objective tolerance:     %s\n", linearTolerance.toString().c_str());
+   printf("\n");
+
+   /* check feasibility of solution and correctness of objective value,
+    * computing the maximum violations in the same pass */
+   CheckResult result;
+   ViolationReport report(nworst);
+   model->evaluate(intTolerance, linearTolerance, result, nthreads, profile, nworst > 0 ? &report : NULL);
+   model->reportFailures(result, intTolerance, linearTolerance);
+
+   printf("Check SOL: Integrality %d Constraints %d Objective %d\n", result.intFeasible, result.linearFeasible, result.correctObj);
+   printf("Maximum violations: Integrality %f Constraints %f Objective %f\n", result.intViol.toDouble(), result.linearViol.toDouble(), result.objViol.toDouble());
+   if( nworst > 0 )
+   {
+      printf("\n");
+      model->reportViolations(report, intTolerance, linearTolerance);
+   }
+}
+
+/**
+ * Check a solution file against a model and print the report.
+ * @param model the model, or NULL if it could not be read
+ * @param profile stores the time of reading the solution and of the phases of the check (if not NULL)
+ * @param nworst number of largest violations to report per ranking (0 for none)
+ */
+static void checkSolution(
+      Model* model,
+      const char* solfile,
+      const Rational& linearTolerance,
+      const Rational& intTolerance,
+      int nthreads,
+      Profile* profile,
+      int nworst = 0)
+{
+   bool success = (model != NULL);
    printf("Read MPS: %d\n", success);
    if( !success )
-      return 0;
+      return;
    printf("MIP has %d vars and %d constraints\n", model->numVars(), model->numConss());
 
    /* read solution */
-   success = model->readSol(argv[2]);
+   if( profile != NULL )
+      profile->begin("read_sol");
+   success = model->readSol(solfile);
+   if( profile != NULL )
+      profile->end();
    printf("Read SOL: %d\n", success);
    if( !success )
-      return 0;
-   if( !model->hasObjectiveValue )
-      printf("No objective value given\n");
-   printf("\n");
+      return;
+   reportCheck(model, linearTolerance, intTolerance, nthreads, profile, nworst);
+}
+
+/**
+ * Check a solution file against an MPS file in a streaming check (see Model::startStreaming()):
+ * the solution is read first, and the nonzeros of the model are not kept.
+ * @param profile stores the time of reading the solution and the model and of the phases of the check (if not NULL)
+ * @param nworst number of largest violations to report per ranking (0 for none)
+ */
+static void streamSolution(
+      const char* mpsfile,
+      const char* solfile,
+      const Rational& linearTolerance,
+      const Rational& intTolerance,
+      int nthreads,
+      Model::Backend backend,
+      Profile* profile,
+      int nworst)
+{
+   Model model;
+   model.backend = backend;
+   model.startStreaming();
+
+   /* read solution */
+   if( profile != NULL )
+      profile->begin("read_sol");
+   bool solRead = model.readSol(solfile);
+   if( profile != NULL )
+      profile->end();
+
+   /* read the model, streaming its nonzeros (parsing in parallel would keep the whole file in memory);
+    * the model is read even if the solution is not, so that the report has the lines of checkSolution() */
+   if( profile != NULL )
+      profile->begin("parse");
+   MpsInput mpsi(1);
+   bool success = mpsi.readMps(mpsfile, &model);
+   if( profile != NULL )
+      profile->end();
+   printf("Read MPS: %d\n", success);
+   if( !success )
+      return;
+   printf("MIP has %d vars and %d constraints\n", model.numVars(), model.numConss());
+
+   /* the solution is only known to be read once all its values have found their variables */
+   success = solRead && model.reportUnexpectedVars() == 0;
+   printf("Read SOL: %d\n", success);
+   if( !success )
+      return;
+   reportCheck(&model, linearTolerance, intTolerance, nthreads, profile, nworst);
+}
+
+int main (int argc, char const *argv[])
+{
+   /* number of threads used for checking */
+   int nthreads = 1;
+   /* check a list of solutions against the model? */
+   bool batch = false;
+   /* check all solutions of solution pool files against the model? */
+   bool pools = false;
+   /* directory of the model cache (NULL for no cache) */
+   const char* cachedir = getenv("SOLCHECKER_CACHE");
+   /* socket of a checker daemon to send the check to (NULL for none) */
+   const char* socketPath = getenv("SOLCHECKER_SOCKET");
+   /* socket to serve requests on, in daemon mode (NULL if not a daemon) */
+   const char* servePath = NULL;
+   /* memory for the models kept by the daemon, in MB */
+   long memoryLimit = 4096;
+   /* seconds without requests after which the daemon stops */
+   int idleTimeout = 3600;
+   /* print the time and memory of each phase as a JSON line? */
+   bool profiling = false;
+   /* number of largest violations to report per ranking (0 for none) */
+   int nworst = 0;
+   /* arithmetic to decide the constraints with */
+   Model::Backend backend = Model::EXACT;
+   /* print the fingerprints of models instead of checking? */
+   bool fingerprint = false;
+   /* stream the nonzeros of the model instead of keeping them? */
+   bool streaming = false;
 
    /* default tolerances */
    Rational linearTolerance(1, 10000);
    Rational intTolerance(linearTolerance);
+   bool intTolGiven = false;
+
+   /* read options */
+   while( argc > 1 && argv[1][0] == '-' )
+   {
+      if( !strcmp(argv[1], "-j") && argc > 2 )
+      {
+         nthreads = atoi(argv[2]);
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strncmp(argv[1], "-j", 2) && argv[1][2] != '\0' )
+      {
+         nthreads = atoi(argv[1] + 2);
+         argc--;
+         argv++;
+      }
+      else if( !strcmp(argv[1], "-l") && argc > 2 )
+      {
+         linearTolerance.fromString(argv[2]);
+         if( !intTolGiven )
+            intTolerance = linearTolerance;
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "-i") && argc > 2 )
+      {
+         intTolerance.fromString(argv[2]);
+         intTolGiven = true;
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "-c") && argc > 2 )
+      {
+         cachedir = argv[2];
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "-b") )
+      {
+         batch = true;
+         argc--;
+         argv++;
+      }
+      else if( !strcmp(argv[1], "-p") )
+      {
+         pools = true;
+         argc--;
+         argv++;
+      }
+      else if( !strcmp(argv[1], "--serve") && argc > 2 )
+      {
+         servePath = argv[2];
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "--socket") && argc > 2 )
+      {
+         socketPath = argv[2];
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "-m") && argc > 2 )
+      {
+         memoryLimit = atol(argv[2]);
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "--profile") )
+      {
+         profiling = true;
+         argc--;
+         argv++;
+      }
+      else if( !strcmp(argv[1], "-w") && argc > 2 )
+      {
+         nworst = std::max(atoi(argv[2]), 0);
+         argc -= 2;
+         argv += 2;
+      }
+      else if( !strcmp(argv[1], "--fingerprint") )
+      {
+         fingerprint = true;
+         argc--;
+         argv++;
+      }
+      else if( !strcmp(argv[1], "--stream") )
+      {
+         streaming = true;
+         argc--;
+         argv++;
+      }
+      else if( !strcmp(argv[1], "--interval") )
+      {
+         backend = Model::INTERVAL;
+         argc--;
+         argv++;
+      }
+      else if( !strcmp(argv[1], "--idle") && argc > 2 )
+      {
+         idleTimeout = atoi(argv[2]);
+         argc -= 2;
+         argv += 2;
+      }
+      else
+         break;
+   }
+   if( nthreads < 1 )
+      nthreads = 1;
+   if( cachedir != NULL && cachedir[0] == '\0' )
+      cachedir = NULL;
+
+   if( servePath != NULL )
+   {
+      /* daemon: the tolerances and whether to profile come with each request */
+      CheckServer server(servePath, (size_t)memoryLimit << 20, idleTimeout,
+         [&](const char* mpsfile) { return readModel(mpsfile, cachedir, nthreads, backend); },
+         [&](Model* model, const char* solfile, const Rational& linTol, const Rational& intTol, Profile* profile)
+         {
+            checkSolution(model, solfile, linTol, intTol, nthreads, profile);
+            if( profile != NULL )
+               profile->print();
+         });
+      return server.run() ? 0 : 1;
+   }
 
-   /* read tolerances */
-   if( argc > 3 )
+   if( fingerprint && argc > 1 )
    {
-      linearTolerance.fromString(argv[3]);
-      intTolerance.fromString(argv[3]);
+      /* one "fingerprint  filename" line per model, as checksum tools print them */
+      int status = 0;
+      for( int i = 1; i < argc; ++i )
+      {
+         Model* model = readModel(argv[i], cachedir, nthreads, backend);
+         if( model == NULL )
+         {
+            printf("cannot read <%s>\n", argv[i]);
+            status = 1;
+            continue;
+         }
+         printf("%016llx  %s\n", (unsigned long long)modelFingerprint(model, nthreads), argv[i]);
+         delete model;
+      }
+      return status;
    }
-   if( argc > 4 )
-      intTolerance.fromString(argv[4]);
+
+   if( argc < 3 || (!batch && !pools && argc > 5) )
+   {
+      printf("Usage: solchecker [-j threads] [-c cachedir] [--socket socket] [--profile] [--interval] [-w worst] [-l linear_tol] [-i int_tol] filename.mps[.gz] solution.sol [linear_tol int_tol]\n");
+      printf("       solchecker [-j threads] --stream [--profile] [--interval] [-w worst] [-l linear_tol] [-i int_tol] filename.mps[.gz] solution.sol [linear_tol int_tol]\n");
+      printf("       solchecker [-j threads] [-c cachedir] [--interval] [-l linear_tol] [-i int_tol] -b filename.mps[.gz] solution.sol|soldir ...\n");
+      printf("       solchecker [-j threads] [-c cachedir] [--interval] [-l linear_tol] [-i int_tol] -p filename.mps[.gz] pool.sol ...\n");
+      printf("       solchecker [-j threads] [-c cachedir] [--interval] [-m megabytes] [--idle seconds] --serve socket\n");
+      printf("       solchecker [-j threads] [-c cachedir] --fingerprint filename.mps[.gz] ...\n");
+      return 0;
+   }
+
+   if( !batch && !pools )
+   {
+      /* read tolerances */
+      if( argc > 3 )
+      {
+         linearTolerance.fromString(argv[3]);
+         intTolerance.fromString(argv[3]);
+      }
+      if( argc > 4 )
+         intTolerance.fromString(argv[4]);
+
+      /* let a checker daemon do the check if there is one, otherwise check here
+       * (the daemon does not report the largest violations and has its own backend) */
+      if( socketPath != NULL && socketPath[0] != '\0' && nworst == 0 && backend == Model::EXACT && !streaming
+         && requestCheck(socketPath, argv[1], argv[2], linearTolerance, intTolerance, profiling) )
+         return 0;
+
+      Profile profile;
+      if( streaming )
+      {
+         streamSolution(argv[1], argv[2], linearTolerance, intTolerance, nthreads, backend, profiling ? &profile : NULL, nworst);
+         if( profiling )
+            profile.print();
+         return 0;
+      }
+      profile.begin("parse");
+      Model* model = readModel(argv[1], cachedir, nthreads, backend);
+      profile.end();
+      checkSolution(model, argv[2], linearTolerance, intTolerance, nthreads, profiling ? &profile : NULL, nworst);
+      if( profiling )
+         profile.print();
+      delete model;
+      return 0;
+   }
+
+   /* read model */
+   Model* model = readModel(argv[1], cachedir, nthreads, backend);
+   bool success = (model != NULL);
+   printf("Read MPS: %d\n", success);
+   if( !success )
+      return 0;
+   printf("MIP has %d vars and %d constraints\n", model->numVars(), model->numConss());
 
    printf("Integrality tolerance:   %s\n", intTolerance.toString().c_str());
    printf("Linear tolerance:        %s\n", linearTolerance.toString().c_str());
    printf("Objective tolerance:     %s\n", linearTolerance.toString().c_str());
    printf("\n");
 
-   /* check feasibility of solution and correctness of objective value */
-   bool intFeas;
-   bool linFeas;
-   bool obj;
-   model->check(intTolerance, linearTolerance, intFeas, linFeas, obj);
-
-   printf("Check SOL: Integrality %d Constraints %d Objective %d\n", intFeas, linFeas, obj);
-
-   /* calculate maximum violations */
-   Rational intViol;
-   Rational linearViol;
-   Rational objViol;
-   model->maxViolations(intViol, linearViol, objViol);
-
-   printf("Maximum violations: Integrality %f Constraints %f Objective %f\n", intViol.toDouble(), linearViol.toDouble(), objViol.toDouble());
+   if( pools )
+      checkPools(model, argv + 2, argc - 2, intTolerance, linearTolerance, nthreads);
+   else
+      checkBatch(model, argv + 2, argc - 2, intTolerance, linearTolerance, nthreads);
 
-   delete mpsi;
    delete model;
    return 0;
 }
@@ -0,0 +1,171 @@
+/**
+ * @file matrix.cpp
+ * @brief Sparse constraint matrix of a MIP model
+ */
+
+#include "matrix.h"
+#include <assert.h>
+
+SparseMatrix::SparseMatrix():ncols(0), compressed(false) {}
+
+int SparseMatrix::addRow(const Rational& _lhs, const Rational& _rhs)
+{
+   lhs.push_back(_lhs);
+   rhs.push_back(_rhs);
+   return lhs.size() - 1;
+}
+
+void SparseMatrix::push(int row, int col, const Rational& val)
+{
+   assert( !compressed );
+   assert( row >= 0 && row < numRows() );
+   assert( col >= 0 );
+   pushedRow.push_back(row);
+   pushedCol.push_back(col);
+   pushedVal.push_back(val);
+}
+
+void SparseMatrix::reserve(int nnz)
+{
+   assert( !compressed );
+   pushedRow.reserve(pushedRow.size() + nnz);
+   pushedCol.reserve(pushedCol.size() + nnz);
+   pushedVal.reserve(pushedVal.size() + nnz);
+}
+
+void SparseMatrix::compress(int _ncols)
+{
+   assert( !compressed );
+   int nrows = numRows();
+   int nnz = pushedRow.size();
+   ncols = _ncols;
+
+   /* count nonzeros per row and per column */
+   rowBeg.assign(nrows + 1, 0);
+   colBeg.assign(ncols + 1, 0);
+   for( int k = 0; k < nnz; ++k )
+   {
+      assert( pushedCol[k] < ncols );
+      rowBeg[pushedRow[k] + 1]++;
+      colBeg[pushedCol[k] + 1]++;
+   }
+   for( int i = 0; i < nrows; ++i )
+      rowBeg[i + 1] += rowBeg[i];
+   for( int j = 0; j < ncols; ++j )
+      colBeg[j + 1] += colBeg[j];
+
+   /* fill rows, keeping the order in which the nonzeros were pushed */
+   std::vector<int> rowNext(rowBeg.begin(), rowBeg.end() - 1);
+   std::vector<int> pos(nnz);
+   rowInd.resize(nnz);
+   rowVal.resize(nnz);
+   for( int k = 0; k < nnz; ++k )
+   {
+      pos[k] = rowNext[pushedRow[k]]++;
+      rowInd[pos[k]] = pushedCol[k];
+      rowVal[pos[k]] = pushedVal[k];
+   }
+
+   /* column-wise index into the row storage */
+   std::vector<int> colNext(colBeg.begin(), colBeg.end() - 1);
+   colInd.resize(nnz);
+   colPos.resize(nnz);
+   for( int k = 0; k < nnz; ++k )
+   {
+      int p = colNext[pushedCol[k]]++;
+      colInd[p] = pushedRow[k];
+      colPos[p] = pos[k];
+   }
+
+   /* release the pushed nonzeros */
+   std::vector<int>().swap(pushedRow);
+   std::vector<int>().swap(pushedCol);
+   std::vector<Rational>().swap(pushedVal);
+
+   roundValues();
+   compressed = true;
+}
+
+void SparseMatrix::buildIndex(int _ncols)
+{
+   assert( !compressed );
+   assert( pushedRow.empty() );
+   assert( (int)rowBeg.size() == numRows() + 1 );
+   int nrows = numRows();
+   int nnz = rowInd.size();
+   ncols = _ncols;
+
+   /* count nonzeros per column */
+   colBeg.assign(ncols + 1, 0);
+   for( int k = 0; k < nnz; ++k )
+   {
+      assert( rowInd[k] < ncols );
+      colBeg[rowInd[k] + 1]++;
+   }
+   for( int j = 0; j < ncols; ++j )
+      colBeg[j + 1] += colBeg[j];
+
+   /* column-wise index into the row storage */
+   std::vector<int> colNext(colBeg.begin(), colBeg.end() - 1);
+   colInd.resize(nnz);
+   colPos.resize(nnz);
+   for( int i = 0; i < nrows; ++i )
+   {
+      for( int k = rowBeg[i]; k < rowBeg[i + 1]; ++k )
+      {
+         int p = colNext[rowInd[k]]++;
+         colInd[p] = i;
+         colPos[p] = k;
+      }
+   }
+
+   roundValues();
+   compressed = true;
+}
+
+void SparseMatrix::roundValues()
+{
+   int nrows = numRows();
+   int nnz = rowInd.size();
+
+   /* rounded copies for the filtered checks */
+   int direction;
+   rowValApprox.resize(nnz);
+   rowValDirection.resize(nnz);
+   for( int k = 0; k < nnz; ++k )
+   {
+      rowValApprox[k] = rowVal[k].toDouble(direction);
+      rowValDirection[k] = direction;
+   }
+   lhsApprox.resize(nrows);
+   rhsApprox.resize(nrows);
+   lhsDirection.resize(nrows);
+   rhsDirection.resize(nrows);
+   for( int i = 0; i < nrows; ++i )
+   {
+      lhsApprox[i] = lhs[i].toDouble(direction);
+      lhsDirection[i] = direction;
+      rhsApprox[i] = rhs[i].toDouble(direction);
+      rhsDirection[i] = direction;
+   }
+}
+
+bool SparseMatrix::isCompressed() const
+{
+   return compressed;
+}
+
+int SparseMatrix::numRows() const
+{
+   return lhs.size();
+}
+
+int SparseMatrix::numCols() const
+{
+   return ncols;
+}
+
+int SparseMatrix::numNonzeros() const
+{
+   return compressed ? rowInd.size() : pushedRow.size();
+}
@@ -0,0 +1,122 @@
+/**
+ * @file matrix.h
+ * @brief Sparse constraint matrix of a MIP model
+ */
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include "gmputils.h"
+#include <vector>
+
+/**
+ * @brief Sparse constraint matrix in compressed row (CSR) and column (CSC) form.
+ * Rows are created with addRow() and nonzeros are added in any order with push().
+ * Once the model is read, compress() builds the CSR arrays (in the order the
+ * nonzeros were pushed) together with a column-wise index into them.
+ * Row bounds are kept in arrays parallel to the rows.
+ * Coefficients and row bounds are also kept rounded to double, for the
+ * filtered (floating-point first) checks, together with the direction of the
+ * rounding error, for the enclosures of the interval checks.
+ */
+class SparseMatrix
+{
+   public:
+      /* left hand sides of the rows */
+      std::vector<Rational> lhs;
+      /* right hand sides of the rows */
+      std::vector<Rational> rhs;
+      /* start of each row in rowInd/rowVal (size numRows() + 1) */
+      std::vector<int> rowBeg;
+      /* column index of each nonzero, row by row */
+      std::vector<int> rowInd;
+      /* coefficient of each nonzero, row by row */
+      std::vector<Rational> rowVal;
+      /* start of each column in colInd/colPos (size numCols() + 1) */
+      std::vector<int> colBeg;
+      /* row index of each nonzero, column by column */
+      std::vector<int> colInd;
+      /* position of each nonzero in rowInd/rowVal, column by column */
+      std::vector<int> colPos;
+      /* rowVal rounded to double */
+      std::vector<double> rowValApprox;
+      /* lhs rounded to double (set by compress()) */
+      std::vector<double> lhsApprox;
+      /* rhs rounded to double (set by compress()) */
+      std::vector<double> rhsApprox;
+      /* where each coefficient lies relative to rowValApprox (see Rational::toDouble(int&)) */
+      std::vector<signed char> rowValDirection;
+      /* where each lhs lies relative to lhsApprox */
+      std::vector<signed char> lhsDirection;
+      /* where each rhs lies relative to rhsApprox */
+      std::vector<signed char> rhsDirection;
+
+      /** Constructor */
+      SparseMatrix();
+
+      /**
+       * Add an empty row
+       * @param _lhs left hand side of the row
+       * @param _rhs right hand side of the row
+       * @return the index of the new row
+       */
+      int addRow(const Rational& _lhs, const Rational& _rhs);
+
+      /**
+       * Add a nonzero to the matrix. Does NOT check for duplicates.
+       * Only allowed before compress().
+       * @param row row index of the nonzero
+       * @param col column index of the nonzero
+       * @param val coefficient
+       */
+      void push(int row, int col, const Rational& val);
+
+      /**
+       * Make room for @param nnz more nonzeros to be pushed, so that the pushed
+       * nonzeros are not copied while they are added
+       */
+      void reserve(int nnz);
+
+      /**
+       * Build the compressed row and column storage from the pushed nonzeros.
+       * @param _ncols number of columns of the matrix
+       */
+      void compress(int _ncols);
+
+      /**
+       * Finish a matrix whose sides and CSR arrays (rowBeg, rowInd, rowVal) were
+       * filled directly instead of with push(), e.g. when loading a cached model:
+       * builds the column-wise index and the rounded copies.
+       * @param _ncols number of columns of the matrix
+       */
+      void buildIndex(int _ncols);
+
+      /** Have the compressed arrays been built? */
+      bool isCompressed() const;
+
+      /** Get number of rows */
+      int numRows() const;
+
+      /** Get number of columns (0 before compress()) */
+      int numCols() const;
+
+      /** Get number of nonzeros */
+      int numNonzeros() const;
+
+   protected:
+      /* number of columns */
+      int ncols;
+      /* are the compressed arrays up to date? */
+      bool compressed;
+      /* row indices of the nonzeros pushed before compress() */
+      std::vector<int> pushedRow;
+      /* column indices of the nonzeros pushed before compress() */
+      std::vector<int> pushedCol;
+      /* coefficients of the nonzeros pushed before compress() */
+      std::vector<Rational> pushedVal;
+
+      /** Fill the rounded copies of coefficients and sides */
+      void roundValues();
+};
+
+#endif
@@ -4,18 +4,143 @@
  */
 
 #include "model.h"
+#include "parallel.h"
+#include "cplexsolinput.h"
+#include "profile.h"
+#include "interval.h"
+#include "rowkernel.h"
 #include "string.h"
 #include <assert.h>
 #include <stdio.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 
 #define SOL_MAX_LINELEN 1024
+#define CHECK_CHUNK     1024
 
-Var::Var(const char* _name, VarType _type, const Rational& _lb, const Rational& _ub, const Rational& _obj):name(_name), type(_type), lb(_lb), ub(_ub), objCoef(_obj) {}
+/* Bound on the rounding error of a double precision expression built from n products
+ * of rounded data (values and coefficients are rounded once, each operation rounds
+ * once more), where magnitude bounds the sum of the absolute values of all terms.
+ * The extra 1% covers magnitude being computed in floating-point as well.
+ */
+static double errorBound(int n, double magnitude)
+{
+   return (n + 10) * DBL_EPSILON * (1.01 * magnitude + DBL_MIN);
+}
+
+void Solution::resize(unsigned int n)
+{
+   values.resize(n);
+   approxValues.resize(n, 0.0);
+   approxDirections.resize(n, 0);
+   isTouched.resize(n, 0);
+}
+
+unsigned int Solution::size() const
+{
+   return values.size();
+}
+
+void Solution::set(unsigned int index, const Rational& val)
+{
+   assert( index < values.size() );
+   if( !isTouched[index] && !val.isZero() )
+   {
+      isTouched[index] = 1;
+      touched.push_back(index);
+   }
+   values[index] = val;
+   int direction;
+   approxValues[index] = val.toDouble(direction);
+   approxDirections[index] = direction;
+}
+
+void Solution::clear()
+{
+   for( unsigned int k = 0; k < touched.size(); ++k )
+   {
+      values[touched[k]].toZero();
+      approxValues[touched[k]] = 0.0;
+      approxDirections[touched[k]] = 0;
+      isTouched[touched[k]] = 0;
+   }
+   touched.clear();
+}
+
+void PoolSolution::fill(Solution& sol) const
+{
+   sol.clear();
+   for( unsigned int k = 0; k < indices.size(); ++k )
+      sol.set(indices[k], values[k]);
+}
+
+void ColumnActivity::compute(const SparseMatrix& matrix, const Solution& sol)
+{
+   assert( matrix.isCompressed() );
+   clear();
+   if( posact.size() < (size_t)matrix.numRows() )
+   {
+      posact.resize(matrix.numRows(), 0.0);
+      negact.resize(matrix.numRows(), 0.0);
+      reached.resize(matrix.numRows(), 0);
+   }
+   const std::vector<unsigned int>& support = sol.support();
+   for( unsigned int s = 0; s < support.size(); ++s )
+   {
+      int col = support[s];
+      /* a value rounding to zero still makes the exact activity nonzero */
+      if( sol[col].isZero() )
+         continue;
+      double value = sol.approx(col);
+      for( int k = matrix.colBeg[col]; k < matrix.colBeg[col + 1]; ++k )
+      {
+         int row = matrix.colInd[k];
+         double prod = matrix.rowValApprox[matrix.colPos[k]] * value;
+         if( !reached[row] )
+         {
+            reached[row] = 1;
+            rows.push_back(row);
+         }
+         if( prod > 0.0 )
+            posact[row] += prod;
+         else
+            negact[row] += prod;
+      }
+   }
+}
 
-bool Var::checkBounds(const Rational& boundTolerance) const
+void ColumnActivity::clear()
 {
+   for( unsigned int i = 0; i < rows.size(); ++i )
+   {
+      posact[rows[i]] = 0.0;
+      negact[rows[i]] = 0.0;
+      reached[rows[i]] = 0;
+   }
+   rows.clear();
+}
+
+Var::Var(const char* _name, VarType _type, const Rational& _lb, const Rational& _ub, const Rational& _obj):name(_name), index(-1), type(_type), lb(_lb), ub(_ub), objCoef(_obj) {}
+
+bool Var::checkBounds(const Rational& value, const Rational& boundTolerance) const
+{
+   if( !withinRelaxedBounds(value, boundTolerance) )
+   {
+      printf("Failed check for var bound: ");
+      print(value);
+      return false;
+   }
+   return true;
+}
+
+bool Var::withinRelaxedBounds(const Rational& value, const Rational& boundTolerance) const
+{
+   /* values within the bounds need no tolerance */
+   if( !(value < lb) && !(value > ub) )
+      return true;
    Rational absx(value);
    absx.abs();
    /* compute lb tolerance */
@@ -37,28 +162,28 @@ bool Var::checkBounds(const Rational& boundTolerance) const
    relaxedLb -= lbtol;
    Rational relaxedUb(ub);
    relaxedUb += ubtol;
-   if( ((value < relaxedLb) || (value > relaxedUb)) && (type != SEMICONTINUOUS || !value.isZero()) )
-   {
-      printf("Failed check for var bound: ");
-      print();
-      return false;
-   }
-   return true;
+   return !(((value < relaxedLb) || (value > relaxedUb)) && (type != SEMICONTINUOUS || !value.isZero()));
 }
 
-bool Var::checkIntegrality(const Rational& intTolerance) const
+bool Var::checkIntegrality(const Rational& value, const Rational& intTolerance) const
 {
    if( type != CONTINUOUS && type != SEMICONTINUOUS && !value.isInteger(intTolerance) )
    {
       printf("Failed check for var integrality: ");
-      print();
+      print(value);
       return false;
    }
    return true;
 }
 
-void Var::boundsViolation(Rational& boundViol) const
+void Var::boundsViolation(const Rational& value, Rational& boundViol) const
 {
+   /* values within the bounds are not violated */
+   if( !(value < lb) && !(value > ub) )
+   {
+      boundViol.toZero();
+      return;
+   }
    Rational lbViol;
    Rational ubViol;
    if( type == SEMICONTINUOUS && value.isZero() )
@@ -78,7 +203,18 @@ void Var::boundsViolation(Rational& boundViol) const
    max(boundViol, lbViol, ubViol);
 }
 
-void Var::integralityViolation(Rational& intViol) const
+void Var::boundsScale(const Rational& value, Rational& scale) const
+{
+   Rational absbound(value < lb ? lb : ub);
+   absbound.abs();
+   Rational absx(value);
+   absx.abs();
+   scale = Rational(1);
+   max(scale, scale, absbound);
+   max(scale, scale, absx);
+}
+
+void Var::integralityViolation(const Rational& value, Rational& intViol) const
 {
    intViol.toZero();
    if( type == CONTINUOUS || type == SEMICONTINUOUS )
@@ -86,9 +222,9 @@ void Var::integralityViolation(Rational& intViol) const
    value.integralityViolation(intViol);
 }
 
-void Var::print() const
+void Var::print(const Rational& value) const
 {
-   std::string vartype;
+   const char* vartype;
    switch(type)
    {
       case BINARY:
@@ -105,96 +241,340 @@ void Var::print() const
       default:
          vartype = "(unknown)";
    }
-   printf("%s [%f,%f]", name.c_str(), lb.toDouble(), ub.toDouble());
-   printf(" %s. Value %f\n", vartype.c_str(), value.toDouble());
+   printf("%s [%f,%f]", name, lb.toDouble(), ub.toDouble());
+   printf(" %s. Value %f\n", vartype, value.toDouble());
 }
 
 Constraint::Constraint(const char* _name)
-   :name(_name), type("<unknown>") {}
+   :name(_name), index(-1), type("<unknown>") {}
 
-LinearConstraint::LinearConstraint(const char* _name, LinearType _lintype, const Rational& _lhs, const Rational& _rhs)
-   :Constraint(_name), lintype(_lintype), lhs(_lhs), rhs(_rhs)
+LinearConstraint::LinearConstraint(const char* _name, LinearType _lintype, Model* _model, const Rational& _lhs, const Rational& _rhs)
+   :Constraint(_name), lintype(_lintype), model(_model)
 {
    type = "<linear>";
+   row = model->matrix.addRow(_lhs, _rhs);
+}
+
+LinearConstraint::LinearConstraint(const char* _name, LinearType _lintype, Model* _model, int _row)
+   :Constraint(_name), lintype(_lintype), model(_model), row(_row)
+{
+   type = "<linear>";
+   assert( row >= 0 && row < model->matrix.numRows() );
+}
+
+Rational& LinearConstraint::lhs()
+{
+   return model->matrix.lhs[row];
+}
+
+const Rational& LinearConstraint::lhs() const
+{
+   return model->matrix.lhs[row];
+}
+
+Rational& LinearConstraint::rhs()
+{
+   return model->matrix.rhs[row];
+}
+
+const Rational& LinearConstraint::rhs() const
+{
+   return model->matrix.rhs[row];
 }
 
 void LinearConstraint::push(Var* v, const Rational& c)
 {
-   vars.push_back(v);
-   coefs.push_back(c);
+   assert( v->index >= 0 );
+   if( model->isStreaming() )
+      model->streamNonzero(row, v->index, c);
+   else
+      model->matrix.push(row, v->index, c);
 }
 
-bool LinearConstraint::check(const Rational& tolerance) const
+void LinearConstraint::checkApprox(const Solution& sol, double tolerance, bool& feasible, bool& withinSides) const
 {
-   /* compute row activity (with its positive and negative parts) */
-   Rational posact;
-   Rational negact;
-   for( unsigned int i = 0; i < vars.size(); ++i )
+   const SparseMatrix& matrix = model->matrix;
+   /* streamed rows have no nonzeros to filter with, their activity is exact already */
+   if( model->isStreaming() )
    {
-      Rational prod;
-      mult(prod, coefs[i], vars[i]->value);
+      feasible = false;
+      withinSides = false;
+      return;
+   }
+   /* compute row activity (with its positive and negative parts) in double precision */
+   RowActivityKernel kernel = rowActivityKernel();
+   int beg = matrix.rowBeg[row];
+   double posact;
+   double negact;
+   kernel(matrix.rowValApprox.data() + beg, matrix.rowInd.data() + beg, sol.approxArray(), matrix.rowBeg[row + 1] - beg, posact, negact);
+   decideApprox(posact, negact, tolerance, feasible, withinSides);
+}
+
+void LinearConstraint::decideApprox(double posact, double negact, double tolerance, bool& feasible, bool& withinSides) const
+{
+   const SparseMatrix& matrix = model->matrix;
+   double activity = posact + negact;
+   double lhs = matrix.lhsApprox[row];
+   double rhs = matrix.rhsApprox[row];
+   /* the bound only depends on the number of products, not on the order they are summed in */
+   int len = matrix.rowBeg[row + 1] - matrix.rowBeg[row];
+   /* same tolerances as in the exact check; negact never contributes to the max */
+   double lhstol = tolerance * std::max(std::max(1.0, posact), fabs(lhs));
+   double rhstol = tolerance * std::max(std::max(1.0, posact), fabs(rhs));
+   double lhserr = errorBound(len, posact - negact + fabs(lhs) + lhstol);
+   double rhserr = errorBound(len, posact - negact + fabs(rhs) + rhstol);
+   /* comparisons fail for non-finite values as well */
+   feasible = (activity - lhs + lhstol > lhserr) && (rhs + rhstol - activity > rhserr);
+   withinSides = (activity - lhs > lhserr) && (rhs - activity > rhserr);
+}
+
+void LinearConstraint::exactActivity(const Solution& sol, Rational& posact, Rational& negact) const
+{
+   if( model->isStreaming() )
+   {
+      model->streamedActivity(row, posact, negact);
+      return;
+   }
+   const SparseMatrix& matrix = model->matrix;
+   posact.toZero();
+   negact.toZero();
+   Rational prod;
+   for( int k = matrix.rowBeg[row]; k < matrix.rowBeg[row + 1]; ++k )
+   {
+      mult(prod, matrix.rowVal[k], sol[matrix.rowInd[k]]);
       if( prod.isPositive() )
          posact += prod;
       else
          negact += prod;
    }
-   Rational activity;
-   activity += posact;
-   activity += negact;
-   /* check lhs, tolerance is: tolerance * max {pospart, negpart, |lhs|, 1} */
-   Rational abslhs(lhs);
+}
+
+void LinearConstraint::relaxedSides(
+      const Rational& posact,
+      const Rational& negact,
+      const Rational& tolerance,
+      Rational& relaxedLhs,
+      Rational& relaxedRhs) const
+{
+   /* lhs, tolerance is: tolerance * max {pospart, negpart, |lhs|, 1} */
+   Rational abslhs(lhs());
    abslhs.abs();
    Rational lhstol(1);
    max(lhstol, lhstol, posact);
    max(lhstol, lhstol, negact);
    max(lhstol, lhstol, abslhs);
    lhstol *= tolerance;
-   Rational relaxedLhs(lhs);
+   relaxedLhs = lhs();
    relaxedLhs -= lhstol;
-   /* check rhs, tolerance is: tolerance * max {pospart, negpart, |rhs|, 1} */
-   Rational absrhs(rhs);
+   /* rhs, tolerance is: tolerance * max {pospart, negpart, |rhs|, 1} */
+   Rational absrhs(rhs());
    absrhs.abs();
    Rational rhstol(1);
    max(rhstol, rhstol, posact);
    max(rhstol, rhstol, negact);
    max(rhstol, rhstol, absrhs);
    rhstol *= tolerance;
-   Rational relaxedRhs(rhs);
+   relaxedRhs = rhs();
    relaxedRhs += rhstol;
-   if( activity < relaxedLhs || activity > relaxedRhs )
-   {
-      printf("Failed check for linear cons %s: %f not in [%f,%f]\n", name.c_str(), activity.toDouble(), relaxedLhs.toDouble(), relaxedRhs.toDouble());
-      return false;
-   }
-   return true;
 }
 
-void LinearConstraint::violation(Rational& viol) const
+void LinearConstraint::sidesViolation(const Rational& activity, Rational& viol) const
 {
-   /* compute row activity */
-   Rational activity;
-   for( unsigned int i = 0; i < vars.size(); ++i )
-      activity.addProduct(coefs[i], vars[i]->value);
-   /* check lhs and rhs */
    Rational lhsViol;
    Rational rhsViol;
-   sub(lhsViol, lhs, activity);
+   sub(lhsViol, lhs(), activity);
    if( lhsViol.isNegative() )
       lhsViol.toZero();
-   sub(rhsViol, activity, rhs);
+   sub(rhsViol, activity, rhs());
    if( rhsViol.isNegative() )
       rhsViol.toZero();
    max(viol, lhsViol, rhsViol);
 }
 
+bool LinearConstraint::check(const Solution& sol, const Rational& tolerance) const
+{
+   assert( model->matrix.isCompressed() );
+   /* rows that are clearly satisfied are decided in floating-point */
+   bool feasible;
+   bool withinSides;
+   checkApprox(sol, tolerance.toDouble(), feasible, withinSides);
+   if( feasible )
+      return true;
+   /* compute row activity (with its positive and negative parts) */
+   Rational posact;
+   Rational negact;
+   exactActivity(sol, posact, negact);
+   Rational activity(posact);
+   activity += negact;
+   Rational relaxedLhs;
+   Rational relaxedRhs;
+   relaxedSides(posact, negact, tolerance, relaxedLhs, relaxedRhs);
+   if( activity < relaxedLhs || activity > relaxedRhs )
+   {
+      printf("Failed check for linear cons %s: %f not in [%f,%f]\n", name, activity.toDouble(), relaxedLhs.toDouble(), relaxedRhs.toDouble());
+      return false;
+   }
+   return true;
+}
+
+void LinearConstraint::violation(const Solution& sol, Rational& viol) const
+{
+   assert( model->matrix.isCompressed() );
+   /* rows whose activity is clearly within the sides are not violated */
+   bool feasible;
+   bool withinSides;
+   checkApprox(sol, 0.0, feasible, withinSides);
+   if( withinSides )
+   {
+      viol.toZero();
+      return;
+   }
+   /* compute row activity */
+   Rational posact;
+   Rational negact;
+   exactActivity(sol, posact, negact);
+   Rational activity(posact);
+   activity += negact;
+   sidesViolation(activity, viol);
+}
+
+bool LinearConstraint::evaluate(const Solution& sol, const Rational& tolerance, Rational& viol) const
+{
+   assert( model->matrix.isCompressed() );
+   bool feasible;
+   bool withinSides;
+   checkApprox(sol, tolerance.toDouble(), feasible, withinSides);
+   return evaluateExact(sol, tolerance, feasible, withinSides, viol);
+}
+
+bool LinearConstraint::evaluate(const Solution& sol, const Rational& tolerance, double posact, double negact, Rational& viol) const
+{
+   assert( model->matrix.isCompressed() );
+   bool feasible;
+   bool withinSides;
+   decideApprox(posact, negact, tolerance.toDouble(), feasible, withinSides);
+   return evaluateExact(sol, tolerance, feasible, withinSides, viol);
+}
+
+bool LinearConstraint::evaluateZero(const Rational& tolerance, Rational& viol) const
+{
+   Rational zero;
+   return evaluateActivity(zero, zero, tolerance, viol);
+}
+
+bool LinearConstraint::evaluateActivity(const Rational& posact, const Rational& negact, const Rational& tolerance, Rational& viol) const
+{
+   Rational activity(posact);
+   activity += negact;
+   sidesViolation(activity, viol);
+   if( viol.isZero() )
+      return true;
+   Rational relaxedLhs;
+   Rational relaxedRhs;
+   relaxedSides(posact, negact, tolerance, relaxedLhs, relaxedRhs);
+   return !(activity < relaxedLhs || activity > relaxedRhs);
+}
+
+bool LinearConstraint::evaluateInterval(const Solution& sol, const Rational& tolerance, Rational& viol) const
+{
+   assert( model->matrix.isCompressed() );
+   if( model->isStreaming() )
+      return evaluate(sol, tolerance, viol);
+   const SparseMatrix& matrix = model->matrix;
+   int direction;
+   double tolApprox = tolerance.toDouble(direction);
+   bool feasible;
+   bool infeasible;
+   bool withinSides;
+   double violUpper;
+   {
+      RoundUpward rounding;
+      /* enclose row activity (with its positive and negative parts) */
+      Interval posact;
+      Interval negact;
+      for( int k = matrix.rowBeg[row]; k < matrix.rowBeg[row + 1]; ++k )
+      {
+         int col = matrix.rowInd[k];
+         Interval prod = Interval::enclose(matrix.rowValApprox[k], matrix.rowValDirection[k])
+            * Interval::enclose(sol.approx(col), sol.approxDirection(col));
+         posact = posact + positivePart(prod);
+         negact = negact + negativePart(prod);
+      }
+      Interval activity = posact + negact;
+      Interval lhs = Interval::enclose(matrix.lhsApprox[row], matrix.lhsDirection[row]);
+      Interval rhs = Interval::enclose(matrix.rhsApprox[row], matrix.rhsDirection[row]);
+      /* same tolerances as in the exact check; negact never contributes to the max */
+      Interval tol = Interval::enclose(tolApprox, direction);
+      Interval scale = max(Interval(1.0), posact);
+      Interval relaxedLhs = lhs - tol * max(scale, abs(lhs));
+      Interval relaxedRhs = rhs + tol * max(scale, abs(rhs));
+      /* comparisons fail for NaN, which leaves the row undecided */
+      feasible = (activity.lo >= relaxedLhs.hi) && (activity.hi <= relaxedRhs.lo);
+      infeasible = (activity.hi < relaxedLhs.lo) || (activity.lo > relaxedRhs.hi);
+      withinSides = (activity.lo >= lhs.hi) && (activity.hi <= rhs.lo);
+      violUpper = std::max(std::max(lhs.hi - activity.lo, activity.hi - rhs.lo), 0.0);
+   }
+   if( withinSides )
+   {
+      viol.toZero();
+      return true;
+   }
+   if( (feasible || infeasible) && isfinite(violUpper) )
+   {
+      viol = Rational(violUpper);
+      return feasible;
+   }
+   /* the enclosure straddles a relaxed side */
+   Rational posact;
+   Rational negact;
+   exactActivity(sol, posact, negact);
+   return evaluateActivity(posact, negact, tolerance, viol);
+}
+
+void LinearConstraint::violationScale(const Solution& sol, Rational& activity, Rational& scale) const
+{
+   Rational posact;
+   Rational negact;
+   exactActivity(sol, posact, negact);
+   activity = posact;
+   activity += negact;
+   Rational absside(activity < lhs() ? lhs() : rhs());
+   absside.abs();
+   scale = Rational(1);
+   max(scale, scale, posact);
+   max(scale, scale, negact);
+   max(scale, scale, absside);
+}
+
+bool LinearConstraint::evaluateExact(const Solution& sol, const Rational& tolerance, bool feasible, bool withinSides, Rational& viol) const
+{
+   /* rows whose activity is clearly within the sides are satisfied and not violated */
+   if( withinSides )
+   {
+      viol.toZero();
+      return true;
+   }
+   /* otherwise the violation is needed exactly; the same activity decides the check */
+   Rational posact;
+   Rational negact;
+   exactActivity(sol, posact, negact);
+   if( !feasible )
+      return evaluateActivity(posact, negact, tolerance, viol);
+   Rational activity(posact);
+   activity += negact;
+   sidesViolation(activity, viol);
+   return true;
+}
+
 void LinearConstraint::print() const
 {
-   printf("%s %s. %f <=", name.c_str(), type.c_str(), lhs.toDouble());
-   for( unsigned int i = 0; i < vars.size(); ++i )
+   const SparseMatrix& matrix = model->matrix;
+   printf("%s %s. %f <=", name, type, lhs().toDouble());
+   for( int k = matrix.rowBeg[row]; k < matrix.rowBeg[row + 1]; ++k )
    {
-      printf(" %f %s", coefs[i].toDouble(), vars[i]->name.c_str());
+      printf(" %f %s", matrix.rowVal[k].toDouble(), model->getVar(matrix.rowInd[k])->name);
    }
-   printf(" <= %f", rhs.toDouble());
+   printf(" <= %f", rhs().toDouble());
    printf("\n");
 }
 
@@ -209,38 +589,64 @@ void SOSConstraint::push(Var* v)
    vars.push_back(v);
 }
 
-bool SOSConstraint::check(const Rational& tolerance) const
+bool SOSConstraint::check(const Solution& sol, const Rational& tolerance) const
 {
    switch(sostype)
    {
       case TYPE_1:
-         return checkType1(tolerance);
+         if( checkType1(sol, tolerance) )
+            return true;
+         printf("Failed check for sos1 cons %s:\n", name);
+         return false;
       case TYPE_2:
-         return checkType2(tolerance);
+         if( checkType2(sol, tolerance) )
+            return true;
+         printf("Failed check for sos2 cons %s:\n", name);
+         return false;
       default :
          return false;
    }
    return false;
 }
 
-void SOSConstraint::violation(Rational& viol) const
+void SOSConstraint::violation(const Solution& sol, Rational& viol) const
 {
    viol.toZero();
 }
 
+bool SOSConstraint::evaluate(const Solution& sol, const Rational& tolerance, Rational& viol) const
+{
+   viol.toZero();
+   switch(sostype)
+   {
+      case TYPE_1:
+         return checkType1(sol, tolerance);
+      case TYPE_2:
+         return checkType2(sol, tolerance);
+      default :
+         return false;
+   }
+   return false;
+}
+
+bool SOSConstraint::evaluateInterval(const Solution& sol, const Rational& tolerance, Rational& viol) const
+{
+   return evaluate(sol, tolerance, viol);
+}
+
 void SOSConstraint::print() const
 {
-   printf("%s %s", name.c_str(), type.c_str());
+   printf("%s %s", name, type);
    if( sostype == TYPE_1 )
       printf("1.");
    else
       printf("2.");
    for( unsigned int i = 0; i < vars.size(); ++i )
-      printf(" %s", vars[i]->name.c_str());
+      printf(" %s", vars[i]->name);
    printf("\n");
 }
 
-bool SOSConstraint::checkType1(const Rational& tolerance) const
+bool SOSConstraint::checkType1(const Solution& sol, const Rational& tolerance) const
 {
    int cnt = 0;
    Rational lb;
@@ -250,19 +656,13 @@ bool SOSConstraint::checkType1(const Rational& tolerance) const
    /* count number of non-zero variables */
    for( unsigned int i = 0; i < vars.size(); ++i )
    {
-      if( (vars[i]->value < lb) || (vars[i]->value > ub) )
+      if( (sol[vars[i]->index] < lb) || (sol[vars[i]->index] > ub) )
          cnt++;
    }
-   if( cnt >= 2)
-   {
-      printf("Failed check for sos1 cons %s:\n", name.c_str());
-      return false;
-   }
-   else
-      return true;
+   return cnt < 2;
 }
 
-bool SOSConstraint::checkType2(const Rational& tolerance) const
+bool SOSConstraint::checkType2(const Solution& sol, const Rational& tolerance) const
 {
    int cnt = 0;
    Rational lb;
@@ -273,7 +673,7 @@ bool SOSConstraint::checkType2(const Rational& tolerance) const
    /* count number of non-zero variables */
    for( unsigned int i = 0; i < vars.size(); ++i )
    {
-      if( (vars[i]->value < lb) || (vars[i]->value > ub) )
+      if( (sol[vars[i]->index] < lb) || (sol[vars[i]->index] > ub) )
       {
          cnt++;
          if( firstIndex == -1 )
@@ -281,13 +681,7 @@ bool SOSConstraint::checkType2(const Rational& tolerance) const
       }
    }
    /* check if var in position (firstIndex + 1) is non-zero */
-   if( cnt <= 1 || (cnt ==2 && (vars[firstIndex + 1]->value < lb) || (vars[firstIndex + 1]->value > ub)) )
-      return true;
-   else
-   {
-      printf("Failed check for sos2 cons %s:\n", name.c_str());
-      return false;
-   }
+   return cnt <= 1 || (cnt ==2 && (sol[vars[firstIndex + 1]->index] < lb) || (sol[vars[firstIndex + 1]->index] > ub));
 }
 
 IndicatorConstraint::IndicatorConstraint(const char* _name, Var* _ifvar, bool _ifvalue, Constraint* _thencons)
@@ -296,97 +690,239 @@ IndicatorConstraint::IndicatorConstraint(const char* _name, Var* _ifvar, bool _i
    type = "<IND>";
 }
 
-IndicatorConstraint::~IndicatorConstraint()
-{
-   delete thencons;
-}
-
-bool IndicatorConstraint::check(const Rational& tolerance) const
+bool IndicatorConstraint::check(const Solution& sol, const Rational& tolerance) const
 {
    Rational half(1,2);
-   if( ifvar->value > half && !ifvalue )
+   if( sol[ifvar->index] > half && !ifvalue )
       return true;
-   if( ifvar->value < half && ifvalue )
+   if( sol[ifvar->index] < half && ifvalue )
       return true;
-   if( thencons->check(tolerance) )
+   if( thencons->check(sol, tolerance) )
       return true;
-   printf("Failed check for indicator cons %s:\n", name.c_str());
+   printf("Failed check for indicator cons %s:\n", name);
    return false;
 }
 
-void IndicatorConstraint::violation(Rational& viol) const
+void IndicatorConstraint::violation(const Solution& sol, Rational& viol) const
 {
    viol.toZero();
    Rational half(1,2);
-   if( ifvar->value > half && !ifvalue )
+   if( sol[ifvar->index] > half && !ifvalue )
       return;
-   if( ifvar->value < half && ifvalue )
+   if( sol[ifvar->index] < half && ifvalue )
       return;
-   thencons->violation(viol);
+   thencons->violation(sol, viol);
 }
 
-void IndicatorConstraint::print() const
+bool IndicatorConstraint::evaluate(const Solution& sol, const Rational& tolerance, Rational& viol) const
 {
-   printf("%s %s. %s == %d -> ", name.c_str(), type.c_str(), ifvar->name.c_str(), ifvalue);
-   thencons->print();
+   viol.toZero();
+   Rational half(1,2);
+   if( sol[ifvar->index] > half && !ifvalue )
+      return true;
+   if( sol[ifvar->index] < half && ifvalue )
+      return true;
+   return thencons->evaluate(sol, tolerance, viol);
 }
 
-Model::Model():objSense(MINIMIZE), hasObjectiveValue(false) {}
-
-Model::~Model()
+bool IndicatorConstraint::evaluateInterval(const Solution& sol, const Rational& tolerance, Rational& viol) const
 {
-   /* delete constraints */
-   std::map<std::string, Constraint*>::iterator citr = conss.begin();
-   std::map<std::string, Constraint*>::iterator cend = conss.end();
-   while( citr != cend )
-   {
-      delete citr->second;
-      ++citr;
-   }
-   conss.clear();
+   viol.toZero();
+   Rational half(1,2);
+   if( sol[ifvar->index] > half && !ifvalue )
+      return true;
+   if( sol[ifvar->index] < half && ifvalue )
+      return true;
+   return thencons->evaluateInterval(sol, tolerance, viol);
+}
 
-   /* delete vars */
-   std::map<std::string, Var*>::iterator vitr = vars.begin();
-   std::map<std::string, Var*>::iterator vend = vars.end();
-   while( vitr != vend )
-   {
-      delete vitr->second;
-      ++vitr;
-   }
-   vars.clear();
+void IndicatorConstraint::print() const
+{
+   printf("%s %s. %s == %d -> ", name, type, ifvar->name, ifvalue);
+   thencons->print();
 }
 
+Model::Model():objSense(MINIMIZE), hasObjectiveValue(false), backend(EXACT), streaming(false) {}
+
+/* variables and constraints are released with the arena */
+Model::~Model() {}
+
 Var* Model::getVar(const char* name) const
 {
-   std::map<std::string, Var*>::const_iterator itr = vars.find(name);
-   if( itr != vars.end() )
-      return itr->second;
+   NameIndex::const_iterator itr = varIndex.find(names.find(name));
+   if( itr != varIndex.end() )
+      return vars[itr->second];
    return NULL;
 }
 
+Var* Model::getVar(unsigned int index) const
+{
+   assert( index < vars.size() );
+   return vars[index];
+}
+
 Constraint* Model::getCons(const char* name) const
 {
-   std::map<std::string, Constraint*>::const_iterator itr = conss.find(name);
-   if( itr != conss.end() )
-      return itr->second;
+   NameIndex::const_iterator itr = consIndex.find(names.find(name));
+   if( itr != consIndex.end() )
+      return conss[itr->second];
    return NULL;
 }
 
+Constraint* Model::getCons(unsigned int index) const
+{
+   assert( index < conss.size() );
+   return conss[index];
+}
+
 void Model::pushVar(Var* var)
 {
    assert( var != NULL );
-   vars[var->name] = var;
+   NameIndex::iterator itr = varIndex.find(var->name);
+   if( itr != varIndex.end() )
+   {
+      var->index = itr->second;
+      vars[var->index] = var;
+      return;
+   }
+   var->index = vars.size();
+   varIndex[var->name] = var->index;
+   vars.push_back(var);
+   if( streaming )
+   {
+      /* the value is needed for the nonzeros of the variable, which follow */
+      solution.resize(vars.size());
+      std::unordered_map<std::string, std::pair<Rational, int> >::iterator value = pendingValues.find(var->name);
+      if( value != pendingValues.end() )
+      {
+         solution.set(var->index, value->second.first);
+         pendingValues.erase(value);
+      }
+   }
 }
 
 void Model::pushCons(Constraint* cons)
 {
    assert( cons != NULL );
-   conss[cons->name] = cons;
+   NameIndex::iterator itr = consIndex.find(cons->name);
+   if( itr != consIndex.end() )
+   {
+      cons->index = itr->second;
+      conss[cons->index] = cons;
+      return;
+   }
+   cons->index = conss.size();
+   consIndex[cons->name] = cons->index;
+   conss.push_back(cons);
 }
 
 void Model::removeCons(const char* name)
 {
-   conss.erase(name);
+   NameIndex::iterator itr = consIndex.find(names.find(name));
+   if( itr == consIndex.end() )
+      return;
+   int pos = itr->second;
+   consIndex.erase(itr);
+   conss[pos]->index = -1;
+   /* move the last constraint into the freed position */
+   Constraint* last = conss.back();
+   conss.pop_back();
+   if( last->index != -1 )
+   {
+      last->index = pos;
+      conss[pos] = last;
+      consIndex[last->name] = pos;
+   }
+}
+
+void Model::startStreaming()
+{
+   assert( vars.empty() && conss.empty() );
+   streaming = true;
+}
+
+void Model::streamNonzero(int row, int col, const Rational& val)
+{
+   const Rational& value = solution[col];
+   if( value.isZero() )
+      return;
+   if( streamedPosact.size() < (size_t)matrix.numRows() )
+   {
+      streamedPosact.resize(matrix.numRows());
+      streamedNegact.resize(matrix.numRows());
+   }
+   Rational prod;
+   mult(prod, val, value);
+   if( prod.isPositive() )
+      streamedPosact[row] += prod;
+   else
+      streamedNegact[row] += prod;
+}
+
+void Model::streamedActivity(int row, Rational& posact, Rational& negact) const
+{
+   if( (size_t)row < streamedPosact.size() )
+   {
+      posact = streamedPosact[row];
+      negact = streamedNegact[row];
+   }
+   else
+   {
+      posact.toZero();
+      negact.toZero();
+   }
+}
+
+int Model::finalize()
+{
+   if( !matrix.isCompressed() )
+      matrix.compress(vars.size());
+   solution.resize(vars.size());
+
+   /* what can be violated when all values are zero */
+   Rational zero;
+   Rational viol;
+   zeroViolatedVars.clear();
+   for( unsigned int i = 0; i < vars.size(); ++i )
+   {
+      vars[i]->boundsViolation(zero, viol);
+      if( !viol.isZero() )
+         zeroViolatedVars.push_back(i);
+   }
+   consRow.assign(conss.size(), -1);
+   rowCons.assign(matrix.numRows(), -1);
+   zeroCheckedConss.clear();
+   otherConss.clear();
+   for( unsigned int i = 0; i < conss.size(); ++i )
+   {
+      const LinearConstraint* lincons = dynamic_cast<const LinearConstraint*>(conss[i]);
+      if( lincons == NULL )
+      {
+         otherConss.push_back(i);
+         continue;
+      }
+      consRow[i] = lincons->row;
+      rowCons[lincons->row] = i;
+      if( lincons->lhs().isPositive() || lincons->rhs().isNegative() )
+         zeroCheckedConss.push_back(i);
+   }
+
+   /* values left in a streaming check are of variables the model does not have */
+   return (int)pendingValues.size();
+}
+
+int Model::reportUnexpectedVars()
+{
+   /* in the order of the solution file */
+   std::vector<std::pair<int, const char*> > unexpected;
+   for( std::unordered_map<std::string, std::pair<Rational, int> >::const_iterator itr = pendingValues.begin(); itr != pendingValues.end(); ++itr )
+      unexpected.push_back(std::make_pair(itr->second.second, itr->first.c_str()));
+   std::sort(unexpected.begin(), unexpected.end());
+   for( unsigned int k = 0; k < unexpected.size(); ++k )
+      printf("unexpected variable <%s> in solution file\n", unexpected[k].second);
+   if( !unexpected.empty() )
+      printf("Encountered %d unexpected variables\n", (int)unexpected.size());
+   return (int)unexpected.size();
 }
 
 unsigned int Model::numVars() const
@@ -399,7 +935,32 @@ unsigned int Model::numConss() const
    return conss.size();
 }
 
+/* remove the solutions without a variable value from @param pool */
+static void dropEmptySolutions(std::vector<PoolSolution>& pool)
+{
+   unsigned int n = 0;
+   for( unsigned int k = 0; k < pool.size(); ++k )
+   {
+      if( pool[k].indices.empty() )
+         continue;
+      if( n < k )
+         std::swap(pool[n], pool[k]);
+      ++n;
+   }
+   pool.resize(n);
+}
+
 bool Model::readSol(const char* filename)
+{
+   return readSolFile(filename, NULL);
+}
+
+bool Model::readSolPool(const char* filename, std::vector<PoolSolution>& pool)
+{
+   return readSolFile(filename, &pool);
+}
+
+bool Model::readSolFile(const char* filename, std::vector<PoolSolution>* pool)
 {
    assert( filename != NULL );
    char buf[SOL_MAX_LINELEN];
@@ -412,7 +973,38 @@ bool Model::readSol(const char* filename)
       return false;
    }
 
-   hasObjectiveValue = false;
+   if( pool == NULL )
+   {
+      hasObjectiveValue = false;
+      solution.resize(vars.size());
+      solution.clear();
+   }
+
+   /* solutions written by CPLEX are XML documents */
+   if( streaming && CplexSolInput::isXml(filename) )
+   {
+      fclose(fp);
+      printf("cannot stream the CPLEX XML solution <%s>\n", filename);
+      return false;
+   }
+   if( CplexSolInput::isXml(filename) )
+   {
+      fclose(fp);
+      CplexSolInput input;
+      bool success = input.readSol(filename, this, pool);
+      if( pool != NULL )
+         dropEmptySolutions(*pool);
+      return success;
+   }
+
+   /* solution of the pool being read (NULL when reading into the current solution) */
+   PoolSolution* current = NULL;
+   if( pool != NULL )
+   {
+      pool->push_back(PoolSolution());
+      current = &pool->back();
+   }
+   int nsolheaders = 0;
    bool hasVarValue = false;
    bool isSolFeas = true;
 
@@ -443,14 +1035,48 @@ bool Model::readSol(const char* filename)
          break;
       }
 
+      if( strcmp(varname, "=sol=") == 0 )
+      {
+         /* start of the next solution: only the first one is read into the current solution */
+         if( current == NULL )
+         {
+            if( nsolheaders++ > 0 )
+               break;
+            continue;
+         }
+         if( !current->indices.empty() || current->hasObjectiveValue )
+         {
+            pool->push_back(PoolSolution());
+            current = &pool->back();
+         }
+         const char* solname = strtok_r(NULL, " ", &nexttok);
+         current->name = (solname != NULL ? solname : "");
+         continue;
+      }
+
       const char* valuep = strtok_r(NULL, " ", &nexttok);
       assert( valuep != NULL );
 
       if( strcmp(varname, "=obj=") == 0 )
       {
          /* read objective value */
-         hasObjectiveValue = true;
-         objectiveValue.fromString(valuep);
+         if( current != NULL )
+         {
+            current->hasObjectiveValue = true;
+            current->objectiveValue.fromString(valuep);
+         }
+         else
+         {
+            hasObjectiveValue = true;
+            objectiveValue.fromString(valuep);
+         }
+      }
+      else if( streaming && pool == NULL )
+      {
+         /* the variables are not read yet, see pushVar() */
+         std::pair<Rational, int>& pending = pendingValues.insert(std::make_pair(std::string(varname), std::make_pair(Rational(), (int)pendingValues.size()))).first->second;
+         pending.first.fromString(valuep);
+         hasVarValue = true;
       }
       else
       {
@@ -460,7 +1086,13 @@ bool Model::readSol(const char* filename)
          {
             Rational value;
             value.fromString(valuep);
-            var->value = value;
+            if( current != NULL )
+            {
+               current->indices.push_back(var->index);
+               current->values.push_back(value);
+            }
+            else
+               solution.set(var->index, value);
             hasVarValue = true;
          }
          else
@@ -478,126 +1110,455 @@ bool Model::readSol(const char* filename)
    fclose(fp);
    fp = NULL;
 
+   if( pool != NULL )
+   {
+      /* a solver claiming infeasibility has no solutions */
+      if( !isSolFeas )
+         pool->clear();
+      dropEmptySolutions(*pool);
+   }
+
    return isSolFeas;
 }
 
-void Model::check(
+CheckResult::CheckResult()
+   :intFeasible(true), linearFeasible(true), correctObj(false), firstVarFailure(-1), firstConsFailure(-1) {}
+
+ViolationReport::ViolationReport(int _k):k(_k) {}
+
+/* order of the heaps of a ViolationReport: the smallest violation on top */
+static bool largerAbsViol(const Violation& a, const Violation& b)
+{
+   return a.absViol > b.absViol;
+}
+
+static bool largerRelViol(const Violation& a, const Violation& b)
+{
+   return a.relViol > b.relViol;
+}
+
+/* add @param violation to the bounded heap @param heap of at most @param k entries */
+static void pushBounded(std::vector<Violation>& heap, int k, const Violation& violation, bool (*larger)(const Violation&, const Violation&))
+{
+   if( k <= 0 || ((int)heap.size() >= k && !larger(violation, heap.front())) )
+      return;
+   for( unsigned int i = 0; i < heap.size(); ++i )
+   {
+      if( heap[i].kind == violation.kind && heap[i].index == violation.index )
+         return;
+   }
+   if( (int)heap.size() >= k )
+   {
+      std::pop_heap(heap.begin(), heap.end(), larger);
+      heap.pop_back();
+   }
+   heap.push_back(violation);
+   std::push_heap(heap.begin(), heap.end(), larger);
+}
+
+bool ViolationReport::mayEnter(double absViol) const
+{
+   if( k <= 0 )
+      return false;
+   return (int)byAbsolute.size() < k || absViol > byAbsolute.front().absViol
+      || (int)byRelative.size() < k || absViol > byRelative.front().relViol;
+}
+
+void ViolationReport::push(const Violation& violation)
+{
+   pushBounded(byAbsolute, k, violation, largerAbsViol);
+   pushBounded(byRelative, k, violation, largerRelViol);
+}
+
+void ViolationReport::merge(const ViolationReport& other)
+{
+   for( unsigned int i = 0; i < other.byAbsolute.size(); ++i )
+      pushBounded(byAbsolute, k, other.byAbsolute[i], largerAbsViol);
+   for( unsigned int i = 0; i < other.byRelative.size(); ++i )
+      pushBounded(byRelative, k, other.byRelative[i], largerRelViol);
+}
+
+void ViolationReport::clear()
+{
+   byAbsolute.clear();
+   byRelative.clear();
+}
+
+std::vector<Violation> ViolationReport::sorted(bool relative) const
+{
+   std::vector<Violation> violations(relative ? byRelative : byAbsolute);
+   std::sort_heap(violations.begin(), violations.end(), relative ? largerRelViol : largerAbsViol);
+   return violations;
+}
+
+/* partial results of Model::evaluate() computed by one thread */
+struct EvaluateState
+{
+   bool intFeasible;
+   bool linearFeasible;
+   int firstVarFailure;
+   int firstConsFailure;
+   Rational intViol;
+   Rational linearViol;
+   Rational objValPlus;
+   Rational objValMinus;
+   ViolationReport report;
+   EvaluateState():intFeasible(true), linearFeasible(true), firstVarFailure(-1), firstConsFailure(-1) {}
+};
+
+/* keep the smallest position of a failure */
+static void recordFailure(int& first, int index)
+{
+   if( first < 0 || index < first )
+      first = index;
+}
+
+void Model::evaluate(
       const Rational& intTolerance,
       const Rational& linearTolerance,
-      bool& intFeasible,
-      bool& linearFeasible,
-      bool& correctObj) const
+      CheckResult& result,
+      int nthreads,
+      Profile* profile,
+      ViolationReport* report) const
 {
-   /* check vars */
-   intFeasible = true;
-   linearFeasible = true;
-   std::map<std::string, Var*>::const_iterator vitr = vars.begin();
-   std::map<std::string, Var*>::const_iterator vend = vars.end();
-   while( vitr != vend && intFeasible && linearFeasible )
+   evaluate(solution, hasObjectiveValue ? &objectiveValue : NULL, intTolerance, linearTolerance, result, nthreads, activity, profile, report);
+}
+
+void Model::evaluate(
+      const Solution& sol,
+      const Rational* reportedObjective,
+      const Rational& intTolerance,
+      const Rational& linearTolerance,
+      CheckResult& result,
+      int nthreads,
+      ColumnActivity& scratch,
+      Profile* profile,
+      ViolationReport* report) const
+{
+   std::vector<EvaluateState> states(std::max(nthreads, 1));
+   if( report != NULL )
    {
-      linearFeasible &= vitr->second->checkBounds(linearTolerance);
-      intFeasible &= vitr->second->checkIntegrality(intTolerance);
-      ++vitr;
+      report->clear();
+      for( unsigned int t = 0; t < states.size(); ++t )
+         states[t].report.k = report->k;
    }
 
-   /* check constraints */
-   std::map<std::string, Constraint*>::const_iterator citr = conss.begin();
-   std::map<std::string, Constraint*>::const_iterator cend = conss.end();
-   while( citr != cend && linearFeasible )
+   /* keep a violation in the report of the thread if it is among the largest so far;
+    * only then is its relative violation computed */
+   auto recordViolation = [&](unsigned int i, Violation::Kind kind, const Rational& viol, EvaluateState& state)
    {
-      linearFeasible &= citr->second->check(linearTolerance);
-      ++citr;
-   }
+      if( report == NULL || viol.isZero() || !state.report.mayEnter(viol.toDouble()) )
+         return;
+      Violation violation;
+      violation.kind = kind;
+      violation.index = i;
+      violation.viol = viol;
+      violation.scale = Rational(1);
+      const LinearConstraint* lincons = NULL;
+      if( kind == Violation::CONSTRAINT )
+         lincons = dynamic_cast<const LinearConstraint*>(conss[i]);
+      else
+         violation.value = sol[i];
+      if( kind == Violation::BOUND )
+         vars[i]->boundsScale(sol[i], violation.scale);
+      else if( lincons != NULL )
+         lincons->violationScale(sol, violation.value, violation.scale);
+      Rational relViol;
+      div(relViol, viol, violation.scale);
+      violation.absViol = viol.toDouble();
+      violation.relViol = relViol.toDouble();
+      state.report.push(violation);
+   };
+
+   /* check a var and accumulate the objective value */
+   auto evaluateVar = [&](unsigned int i, EvaluateState& state, Rational& viol, Rational& prod)
+   {
+      const Rational& value = sol[i];
+      vars[i]->boundsViolation(value, viol);
+      max(state.linearViol, viol, state.linearViol);
+      recordViolation(i, Violation::BOUND, viol, state);
+      bool failed = false;
+      if( !viol.isZero() && !vars[i]->withinRelaxedBounds(value, linearTolerance) )
+      {
+         state.linearFeasible = false;
+         failed = true;
+      }
+      /* same violation as used by the integrality check */
+      vars[i]->integralityViolation(value, viol);
+      max(state.intViol, viol, state.intViol);
+      recordViolation(i, Violation::INTEGRALITY, viol, state);
+      if( viol > intTolerance )
+      {
+         state.intFeasible = false;
+         failed = true;
+      }
+      if( failed )
+         recordFailure(state.firstVarFailure, i);
+      if( !value.isZero() && !vars[i]->objCoef.isZero() )
+      {
+         mult(prod, vars[i]->objCoef, value);
+         if( prod.isPositive() )
+            state.objValPlus += prod;
+         else
+            state.objValMinus += prod;
+      }
+   };
 
-   /* check objective function */
-   correctObj = false;
-   if( hasObjectiveValue )
+   /* check a constraint, with the column-wise activity of its row if given */
+   auto evaluateCons = [&](unsigned int i, EvaluateState& state, Rational& viol, bool columnwise)
    {
-      correctObj = true;
-      Rational objValPlus;
-      Rational objvalMinus;
+      bool feasible;
+      if( columnwise && consRow[i] >= 0 )
+      {
+         int row = consRow[i];
+         const LinearConstraint* lincons = static_cast<const LinearConstraint*>(conss[i]);
+         if( !scratch.isReached(row) )
+            feasible = lincons->evaluateZero(linearTolerance, viol);
+         else if( backend == INTERVAL )
+            feasible = lincons->evaluateInterval(sol, linearTolerance, viol);
+         else
+            feasible = lincons->evaluate(sol, linearTolerance, scratch.posact[row], scratch.negact[row], viol);
+      }
+      else if( backend == INTERVAL )
+         feasible = conss[i]->evaluateInterval(sol, linearTolerance, viol);
+      else
+         feasible = conss[i]->evaluate(sol, linearTolerance, viol);
+      if( !feasible )
+      {
+         state.linearFeasible = false;
+         recordFailure(state.firstConsFailure, i);
+      }
+      max(state.linearViol, viol, state.linearViol);
+      recordViolation(i, Violation::CONSTRAINT, viol, state);
+   };
 
-      vitr = vars.begin();
-      while( vitr != vend )
+   /* go column-wise if the columns of the support hold less than half of the nonzeros */
+   const std::vector<unsigned int>& support = sol.support();
+   bool finalized = (consRow.size() == conss.size() && rowCons.size() == (size_t)matrix.numRows());
+   bool columnwise = matrix.isCompressed() && finalized && !streaming;
+   if( columnwise )
+   {
+      long long supportNonzeros = 0;
+      for( unsigned int s = 0; s < support.size(); ++s )
+         supportNonzeros += matrix.colBeg[support[s] + 1] - matrix.colBeg[support[s]];
+      columnwise = (2 * supportNonzeros < matrix.numNonzeros());
+   }
+
+   if( !columnwise )
+   {
+      /* dense solution: check all vars and constraints (the non-linear ones below, if known) */
+      if( profile != NULL )
+         profile->begin("bounds_integrality");
+      parallelFor(vars.size(), CHECK_CHUNK, nthreads, [&](unsigned int begin, unsigned int end, int thread)
       {
+         Rational viol;
          Rational prod;
+         for( unsigned int i = begin; i < end; ++i )
+            evaluateVar(i, states[thread], viol, prod);
+      });
+      if( profile != NULL )
+         profile->begin("linear");
+      parallelFor(conss.size(), CHECK_CHUNK, nthreads, [&](unsigned int begin, unsigned int end, int thread)
+      {
+         Rational viol;
+         for( unsigned int i = begin; i < end; ++i )
+         {
+            if( finalized && consRow[i] < 0 )
+               continue;
+            evaluateCons(i, states[thread], viol, false);
+         }
+      });
+   }
+   else
+   {
+      /* sparse solution: a var outside the support is zero, and a linear constraint whose row has
+       * no nonzero in the support has zero activity; those satisfied at zero need no check */
+      if( profile != NULL )
+         profile->begin("bounds_integrality");
+      std::vector<unsigned int> checkVars;
+      for( unsigned int k = 0; k < zeroViolatedVars.size(); ++k )
+      {
+         if( sol[zeroViolatedVars[k]].isZero() )
+            checkVars.push_back(zeroViolatedVars[k]);
+      }
+      for( unsigned int s = 0; s < support.size(); ++s )
+      {
+         if( !sol[support[s]].isZero() )
+            checkVars.push_back(support[s]);
+      }
+      parallelFor(checkVars.size(), CHECK_CHUNK, nthreads, [&](unsigned int begin, unsigned int end, int thread)
+      {
+         Rational viol;
+         Rational prod;
+         for( unsigned int k = begin; k < end; ++k )
+            evaluateVar(checkVars[k], states[thread], viol, prod);
+      });
 
-         mult(prod, vitr->second->objCoef, vitr->second->value);
-         if( prod.isPositive() )
-            objValPlus += prod;
-         else
-            objvalMinus += prod;
-         ++vitr;
+      if( profile != NULL )
+         profile->begin("linear");
+      scratch.compute(matrix, sol);
+      /* constraints may be listed twice, which does not change the result */
+      std::vector<unsigned int> checkConss(zeroCheckedConss.begin(), zeroCheckedConss.end());
+      for( unsigned int r = 0; r < scratch.rows.size(); ++r )
+      {
+         int cons = rowCons[scratch.rows[r]];
+         if( cons >= 0 )
+            checkConss.push_back(cons);
       }
+      parallelFor(checkConss.size(), CHECK_CHUNK, nthreads, [&](unsigned int begin, unsigned int end, int thread)
+      {
+         Rational viol;
+         for( unsigned int k = begin; k < end; ++k )
+            evaluateCons(checkConss[k], states[thread], viol, true);
+      });
+      scratch.clear();
+   }
+
+   /* SOS and indicator constraints */
+   if( profile != NULL )
+      profile->begin("sos_indicator");
+   parallelFor(otherConss.size(), CHECK_CHUNK, nthreads, [&](unsigned int begin, unsigned int end, int thread)
+   {
+      Rational viol;
+      for( unsigned int k = begin; k < end; ++k )
+         evaluateCons(otherConss[k], states[thread], viol, false);
+   });
 
-      Rational objVal(objConstant);
-      objVal += objValPlus;
-      objVal += objvalMinus;
+   /* reduce */
+   if( profile != NULL )
+      profile->begin("objective");
+   result = CheckResult();
+   Rational objValPlus;
+   Rational objValMinus;
+   for( unsigned int t = 0; t < states.size(); ++t )
+   {
+      result.intFeasible &= states[t].intFeasible;
+      result.linearFeasible &= states[t].linearFeasible;
+      if( states[t].firstVarFailure >= 0 )
+         recordFailure(result.firstVarFailure, states[t].firstVarFailure);
+      if( states[t].firstConsFailure >= 0 )
+         recordFailure(result.firstConsFailure, states[t].firstConsFailure);
+      max(result.intViol, states[t].intViol, result.intViol);
+      max(result.linearViol, states[t].linearViol, result.linearViol);
+      objValPlus += states[t].objValPlus;
+      objValMinus += states[t].objValMinus;
+      if( report != NULL )
+         report->merge(states[t].report);
+   }
 
-      Rational absobj(objectiveValue);
+   checkObjective(objValPlus, objValMinus, reportedObjective, linearTolerance, result);
+   if( profile != NULL )
+      profile->end();
+}
+
+void Model::checkObjective(
+      const Rational& objValPlus,
+      const Rational& objValMinus,
+      const Rational* reportedObjective,
+      const Rational& linearTolerance,
+      CheckResult& result) const
+{
+   result.objVal = objConstant;
+   result.objVal += objValPlus;
+   result.objVal += objValMinus;
+   result.objViol.toZero();
+   result.correctObj = false;
+   if( reportedObjective != NULL )
+   {
+      Rational absobj(*reportedObjective);
       absobj.abs();
       Rational objtol(1);
       max(objtol, objtol, objValPlus);
-      max(objtol, objtol, objvalMinus);
+      max(objtol, objtol, objValMinus);
       max(objtol, objtol, absobj);
       objtol *= linearTolerance;
 
-      Rational diff;
-      sub(diff, objVal, objectiveValue);
-      diff.abs();
-      if( diff > objtol )
-      {
-         correctObj = false;
-         printf("Failed check for objective value: %f != %f\n", objectiveValue.toDouble(), objVal.toDouble());
-      }
+      sub(result.objViol, result.objVal, *reportedObjective);
+      result.objViol.abs();
+      result.correctObj = !(result.objViol > objtol);
    }
 }
 
-void Model::maxViolations(
-      Rational& intViol,
-      Rational& linearViol,
-      Rational& objViol) const
+void Model::reportFailures(
+      const CheckResult& result,
+      const Rational& intTolerance,
+      const Rational& linearTolerance) const
 {
-   /* check vars */
-   intViol.toZero();
-   linearViol.toZero();
-   objViol.toZero();
-   std::map<std::string, Var*>::const_iterator vitr = vars.begin();
-   std::map<std::string, Var*>::const_iterator vend = vars.end();
-   while( vitr != vend )
-   {
-      Rational viol;
-      vitr->second->boundsViolation(viol);
-      max(linearViol, viol, linearViol);
-      vitr->second->integralityViolation(viol);
-      max(intViol, viol, intViol);
-      ++vitr;
-   }
-   /* check constraints */
-   std::map<std::string, Constraint*>::const_iterator citr = conss.begin();
-   std::map<std::string, Constraint*>::const_iterator cend = conss.end();
-   while( citr != cend )
+   if( result.firstVarFailure >= 0 )
    {
-      Rational viol;
-      citr->second->violation(viol);
-      max(linearViol, viol, linearViol);
-      ++citr;
+      const Var* var = vars[result.firstVarFailure];
+      var->checkBounds(solution[var->index], linearTolerance);
+      var->checkIntegrality(solution[var->index], intTolerance);
    }
-   /* check objective */
-   if( hasObjectiveValue )
+   if( result.firstConsFailure >= 0 )
+      conss[result.firstConsFailure]->check(solution, linearTolerance);
+   if( hasObjectiveValue && !result.correctObj )
+      printf("Failed check for objective value: %f != %f\n", objectiveValue.toDouble(), result.objVal.toDouble());
+}
+
+void Model::reportViolations(
+      const ViolationReport& report,
+      const Rational& intTolerance,
+      const Rational& linearTolerance) const
+{
+   for( int relative = 0; relative <= 1; ++relative )
    {
-      Rational objVal(objConstant);
-      vitr = vars.begin();
-      while( vitr != vend )
+      std::vector<Violation> violations = report.sorted(relative);
+      printf("Largest %s violations: %d\n", relative ? "relative" : "absolute", (int)violations.size());
+      for( unsigned int i = 0; i < violations.size(); ++i )
       {
-         objVal.addProduct(vitr->second->objCoef, vitr->second->value);
-         ++vitr;
+         const Violation& violation = violations[i];
+         const Rational& tolerance = (violation.kind == Violation::INTEGRALITY ? intTolerance : linearTolerance);
+         printf("%3u ", i + 1);
+         if( violation.kind == Violation::CONSTRAINT )
+         {
+            const Constraint* cons = conss[violation.index];
+            printf("cons %s %s", cons->name, cons->type);
+            const LinearConstraint* lincons = dynamic_cast<const LinearConstraint*>(cons);
+            if( lincons != NULL )
+               printf(" activity %g sides [%g,%g]", violation.value.toDouble(), lincons->lhs().toDouble(), lincons->rhs().toDouble());
+         }
+         else
+         {
+            const Var* var = vars[violation.index];
+            printf("%s var %s value %g", violation.kind == Violation::BOUND ? "bound" : "integrality", var->name, violation.value.toDouble());
+            if( violation.kind == Violation::BOUND )
+               printf(" bounds [%g,%g]", var->lb.toDouble(), var->ub.toDouble());
+         }
+         printf(" violation %g relative %g tolerance %g\n", violation.absViol, violation.relViol, tolerance.toDouble());
       }
-      sub(objViol, objVal, objectiveValue);
-      objViol.abs();
    }
 }
 
+void Model::check(
+      const Rational& intTolerance,
+      const Rational& linearTolerance,
+      bool& intFeasible,
+      bool& linearFeasible,
+      bool& correctObj,
+      int nthreads) const
+{
+   CheckResult result;
+   evaluate(intTolerance, linearTolerance, result, nthreads);
+   reportFailures(result, intTolerance, linearTolerance);
+   intFeasible = result.intFeasible;
+   linearFeasible = result.linearFeasible;
+   correctObj = result.correctObj;
+}
+
+void Model::maxViolations(
+      Rational& intViol,
+      Rational& linearViol,
+      Rational& objViol,
+      int nthreads) const
+{
+   CheckResult result;
+   evaluate(Rational(), Rational(), result, nthreads);
+   intViol = result.intViol;
+   linearViol = result.linearViol;
+   objViol = result.objViol;
+}
+
 void Model::print() const
 {
    std::string sense;
@@ -608,44 +1569,24 @@ void Model::print() const
    printf("Model: %s, %s\n", modelName.c_str(), sense.c_str());
 
    printf("Obj: objName:");
-   std::map<std::string, Var*>::const_iterator vitr = vars.begin();
-   std::map<std::string, Var*>::const_iterator vend = vars.end();
-   while( vitr != vend )
-   {
-      printf(" %s %s", vitr->second->objCoef.toString().c_str(), vitr->second->name.c_str());
-      ++vitr;
-   }
+   for( unsigned int i = 0; i < vars.size(); ++i )
+      printf(" %s %s", vars[i]->objCoef.toString().c_str(), vars[i]->name);
    printf("\n");
 
    printf("Constraints\n");
-   std::map<std::string, Constraint*>::const_iterator citr = conss.begin();
-   std::map<std::string, Constraint*>::const_iterator cend = conss.end();
-   while( citr != cend )
-   {
-      citr->second->print();
-      ++citr;
-   }
+   for( unsigned int i = 0; i < conss.size(); ++i )
+      conss[i]->print();
    printf("\n");
 
    printf("Variables\n");
-   vitr = vars.begin();
-   vend = vars.end();
-   while( vitr != vend )
-   {
-      vitr->second->print();
-      ++vitr;
-   }
+   for( unsigned int i = 0; i < vars.size(); ++i )
+      vars[i]->print(solution[i]);
    printf("\n");
 }
 
 void Model::printSol() const
 {
    printf("Solution:\n");
-   std::map<std::string, Var*>::const_iterator vitr = vars.begin();
-   std::map<std::string, Var*>::const_iterator vend = vars.end();
-   while( vitr != vend )
-   {
-      printf("%s = %f\n", vitr->second->name.c_str(), vitr->second->value.toDouble());
-      ++vitr;
-   }
+   for( unsigned int i = 0; i < vars.size(); ++i )
+      printf("%s = %f\n", vars[i]->name, solution[i].toDouble());
 }
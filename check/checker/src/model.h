@@ -6,17 +6,144 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include "arena.h"
 #include "gmputils.h"
+#include "matrix.h"
 #include <string>
 #include <vector>
 #include <iosfwd>
-#include <map>
+#include <unordered_map>
 
 
+class Model;
+class Profile;
+
+/**
+ * @brief Values of the variables in a solution, indexed by variable position.
+ * Each value is kept exactly and rounded to double, so that checks can first
+ * try to decide in floating-point and fall back to exact arithmetic.
+ */
+class Solution
+{
+   public:
+      /**
+       * Set the number of values. New values are zero.
+       * @param n number of variables
+       */
+      void resize(unsigned int n);
+
+      /** Get number of values */
+      unsigned int size() const;
+
+      /** Exact value of variable at position @param index */
+      const Rational& operator[](unsigned int index) const { return values[index]; }
+
+      /** Value of variable at position @param index rounded to double */
+      double approx(unsigned int index) const { return approxValues[index]; }
+
+      /** All values rounded to double, indexed by variable position */
+      const double* approxArray() const { return approxValues.data(); }
+
+      /** Where the value at position @param index lies relative to approx() (see Rational::toDouble(int&)) */
+      int approxDirection(unsigned int index) const { return approxDirections[index]; }
+
+      /**
+       * Set the value of a variable
+       * @param index position of the variable
+       * @param val new value
+       */
+      void set(unsigned int index, const Rational& val);
+
+      /**
+       * Reset all values to zero.
+       * Only the values set to nonzero since the last clear() are touched,
+       * so the cost depends on the support of the solution, not on the model size.
+       */
+      void clear();
+
+      /**
+       * Positions of the values set to nonzero since the last clear(), each listed once.
+       * Every nonzero value is listed; listed values may have been set back to zero.
+       */
+      const std::vector<unsigned int>& support() const { return touched; }
+
+   protected:
+      /* exact values */
+      std::vector<Rational> values;
+      /* values rounded to double */
+      std::vector<double> approxValues;
+      /* where the values lie relative to the rounded ones */
+      std::vector<signed char> approxDirections;
+      /* positions of the values set to nonzero since the last clear() */
+      std::vector<unsigned int> touched;
+      /* is the position in touched? */
+      std::vector<char> isTouched;
+};
+
+/**
+ * @brief A member of a solution pool, kept sparse until it is checked:
+ * the nonzero values read for it and the objective value reported by the solver.
+ */
+class PoolSolution
+{
+   public:
+      /* name of the solution in the file (may be empty) */
+      std::string name;
+      /* positions of the variables with a value, in the order read */
+      std::vector<unsigned int> indices;
+      /* values of these variables */
+      std::vector<Rational> values;
+      /* do we have the objective value of the solution as reported by the solver? */
+      bool hasObjectiveValue;
+      /* objective value of the solution as reported by the solver */
+      Rational objectiveValue;
+
+      /** Constructor */
+      PoolSolution():hasObjectiveValue(false) {}
+
+      /**
+       * Store the values in @param sol, which is cleared first
+       */
+      void fill(Solution& sol) const;
+};
+
+/**
+ * @brief Row activities of a solution, accumulated column by column in double precision.
+ * Only the columns in the support of the solution are visited, so the cost is proportional
+ * to the nonzeros of these columns rather than to the size of the matrix.
+ * As in the row-wise check, activities are split into their positive and negative parts.
+ */
+class ColumnActivity
+{
+   public:
+      /* positive part of the activity of each row (zero for rows not in rows) */
+      std::vector<double> posact;
+      /* negative part of the activity of each row (zero for rows not in rows) */
+      std::vector<double> negact;
+      /* rows with a nonzero in a column of the support, in the order they were reached */
+      std::vector<int> rows;
+
+      /**
+       * Accumulate the activities of the rows of @param matrix for the nonzero values of
+       * @param sol. The activities of a previous call are cleared first.
+       */
+      void compute(const SparseMatrix& matrix, const Solution& sol);
+
+      /** Reset the activities to zero (only the rows reached by the last compute() are touched) */
+      void clear();
+
+      /** Is @param row in rows? Otherwise its activity is exactly zero. */
+      bool isReached(int row) const { return reached[row] != 0; }
+
+   protected:
+      /* is the row in rows? */
+      std::vector<char> reached;
+};
+
 /**
  * @brief Class representing a problem variable.
- * Holds global variable information (such as bounds and objective coefficent)
- * and a solution value (default to zero)
+ * Holds global variable information (such as bounds and objective coefficent).
+ * Solution values are stored by the model, indexed by the variable position.
  */
 class Var
 {
@@ -32,7 +159,9 @@ class Var
          CONTINUOUS
       };
       /* name of the variable */
-      std::string name;
+      const char* name;
+      /* position of the variable in the model (-1 if not in a model) */
+      int index;
       /* type of domain */
       VarType type;
       /* global lower bound */
@@ -41,11 +170,9 @@ class Var
       Rational ub;
       /* objective coefficent */
       Rational objCoef;
-      /* solution value (default is zero) */
-      Rational value;
       /**
-       * Constructor
-       * @param _name name of the variable
+       * Constructor. Variables of a model are created with Model::create().
+       * @param _name name of the variable (not copied, must outlive the variable)
        * @param _type type of domain
        * @param _lb global lower bound
        * @param _ub global upper bound
@@ -54,36 +181,53 @@ class Var
       Var(const char* _name, VarType _type, const Rational& _lb, const Rational& _ub, const Rational& _obj);
 
       /**
-       * Check if the current value of the variable is within its bounds.
+       * Check if a value of the variable is within its bounds.
+       * @param value solution value of the variable
        * @param boundTolerance absolute tolerance for bounds check
        * @return true if the variable satisfies its bounds, false otherwise
        */
-      bool checkBounds(const Rational& boundTolerance) const;
+      bool checkBounds(const Rational& value, const Rational& boundTolerance) const;
 
       /**
-       * Check if the current value of the variable satisfies the integrality requirement.
+       * Same as checkBounds(), but does not print anything.
+       * @param value solution value of the variable
+       * @param boundTolerance absolute tolerance for bounds check
+       * @return true if the variable satisfies its bounds, false otherwise
+       */
+      bool withinRelaxedBounds(const Rational& value, const Rational& boundTolerance) const;
+
+      /**
+       * Check if a value of the variable satisfies the integrality requirement.
        * This check is always true if the variable is continuous.
+       * @param value solution value of the variable
        * @param intTolerance absolute tolerance for integrality check
        * @return true if the value is integral or the variable is continuous, false otherwise
        */
-      bool checkIntegrality(const Rational& intTolerance) const;
+      bool checkIntegrality(const Rational& value, const Rational& intTolerance) const;
 
       /**
-       * Calculate the bounds violation of the variable (0 if not violated).
+       * Calculate the bounds violation of a value of the variable (0 if not violated).
        * Return value is in @param boundViol
        */
-      void boundsViolation(Rational& boundViol) const;
+      void boundsViolation(const Rational& value, Rational& boundViol) const;
+
+      /**
+       * Calculate the scale of the tolerance of the bound violated by a value of the variable,
+       * max {|bound|, |value|, 1} as in checkBounds()
+       * Return value is in @param scale
+       */
+      void boundsScale(const Rational& value, Rational& scale) const;
 
       /**
-       * Calculate the integrality violation of the variable (0 if not violated).
+       * Calculate the integrality violation of a value of the variable (0 if not violated).
        * Return value is in @param intViol
        */
-      void integralityViolation(Rational& intViol) const;
+      void integralityViolation(const Rational& value, Rational& intViol) const;
 
       /**
-       * Print a description of the variable (for debugging)
+       * Print a description of the variable with a given value (for debugging)
        */
-      void print() const;
+      void print(const Rational& value) const;
 };
 
 /**
@@ -93,14 +237,16 @@ class Constraint
 {
    public:
       /* name of the constraint */
-      std::string name;
+      const char* name;
+      /* position of the constraint in the model (-1 if not in a model) */
+      int index;
       /* constraint type */
-      std::string type;
+      const char* type;
       /* is the constraint redundant in the model? */
       bool redundant;
       /**
-       * Constructor
-       * @param _name name of the constraint
+       * Constructor. Constraints of a model are created with Model::create().
+       * @param _name name of the constraint (not copied, must outlive the constraint)
        */
       Constraint(const char* _name);
 
@@ -111,17 +257,41 @@ class Constraint
       virtual ~Constraint() {}
 
       /**
-       * Check if the constraint is satisfied by the current values of its variables.
+       * Check if the constraint is satisfied by the given values of its variables.
+       * @param sol solution values of the variables
        * @param tolerance tolerance for checking feasibility
        * @return true if the constraint is satisfied, false otherwise.
        */
-      virtual bool check(const Rational& tolerance) const =0;
+      virtual bool check(const Solution& sol, const Rational& tolerance) const =0;
 
       /**
-       * Calculate the constraint violation
+       * Calculate the constraint violation for the given values of its variables
        * Return value is in @param viol
        */
-      virtual void violation(Rational& viol) const =0;
+      virtual void violation(const Solution& sol, Rational& viol) const =0;
+
+      /**
+       * Compute check() and violation() together, in a single pass over the constraint.
+       * Does not print anything.
+       * @param sol solution values of the variables
+       * @param tolerance tolerance for checking feasibility
+       * @param viol stores the constraint violation
+       * @return true if the constraint is satisfied, false otherwise.
+       */
+      virtual bool evaluate(const Solution& sol, const Rational& tolerance, Rational& viol) const =0;
+
+      /**
+       * Same as evaluate(), in interval arithmetic (see interval.h): the constraint is
+       * decided on outward-rounded enclosures of its data, and in exact arithmetic only if
+       * the enclosure does not decide it, i.e. it straddles the tolerance boundary.
+       * The violation is exact if zero or decided exactly, otherwise it is the upper end of
+       * its enclosure.
+       * @param sol solution values of the variables
+       * @param tolerance tolerance for checking feasibility
+       * @param viol stores the constraint violation
+       * @return true if the constraint is satisfied, false otherwise.
+       */
+      virtual bool evaluateInterval(const Solution& sol, const Rational& tolerance, Rational& viol) const =0;
 
       /**
        * Print a description of the constraint (for debugging)
@@ -132,7 +302,8 @@ class Constraint
 /**
  * @brief Class representing a linear constraint.
  * Constraints are always stored as ranged constraints, i.e.
- * as lhs <= a^T x <= rhs, and in sparse form.
+ * as lhs <= a^T x <= rhs. Coefficients and sides are stored in a row of
+ * the constraint matrix of the model.
  */
 class LinearConstraint:public Constraint
 {
@@ -149,23 +320,37 @@ class LinearConstraint:public Constraint
       };
       /* constraint type */
       LinearType lintype;
-      /* list of variables */
-      std::vector<Var*> vars;
-      /* list of corresponding coefficients */
-      std::vector<Rational> coefs;
-      /* left hand side */
-      Rational lhs;
-      /* right hand side */
-      Rational rhs;
+      /* model holding the constraint matrix */
+      Model* model;
+      /* row of the constraint in the constraint matrix */
+      int row;
 
       /**
-       * Constructor
+       * Constructor. Adds a new row to the constraint matrix of the model.
        * @param _name name of the constraint
        * @param _lintype type of constraint
+       * @param _model model holding the constraint matrix
        * @param _lhs left hand side of the constraint
        * @param _rhs right hand side of the constraint
        */
-      LinearConstraint(const char* _name, LinearType _lintype, const Rational& _lhs, const Rational& _rhs);
+      LinearConstraint(const char* _name, LinearType _lintype, Model* _model, const Rational& _lhs, const Rational& _rhs);
+
+      /**
+       * Constructor for a constraint whose row already exists in the constraint matrix.
+       * @param _name name of the constraint
+       * @param _lintype type of constraint
+       * @param _model model holding the constraint matrix
+       * @param _row row of the constraint in the constraint matrix
+       */
+      LinearConstraint(const char* _name, LinearType _lintype, Model* _model, int _row);
+
+      /** left hand side */
+      Rational& lhs();
+      const Rational& lhs() const;
+
+      /** right hand side */
+      Rational& rhs();
+      const Rational& rhs() const;
 
       /**
        * Add a variable to the constraint. Does NOT check for duplicates.
@@ -185,21 +370,93 @@ class LinearConstraint:public Constraint
        * and we still put 1 into the arguments of max in order to get back to an absolute tolerance
        * in case of small values. The same reasoning applies for lhs, of course.
        *
+       * @param sol solution values of the variables
        * @param tolerance tolerance for checking feasibility
        * @return true if the constraint is satisfied, false otherwise.
        */
-      bool check(const Rational& tolerance) const;
+      bool check(const Solution& sol, const Rational& tolerance) const;
 
       /**
        * Calculate the constraint violation
        * Return value is in @param viol
        */
-      void violation(Rational& viol) const;
+      void violation(const Solution& sol, Rational& viol) const;
+
+      /**
+       * Compute check() and violation() with a single activity computation
+       */
+      bool evaluate(const Solution& sol, const Rational& tolerance, Rational& viol) const;
+
+      /**
+       * Same as evaluate(), with the activity already accumulated in double precision
+       * (e.g. column-wise, see ColumnActivity)
+       * @param posact positive part of the activity
+       * @param negact negative part of the activity
+       */
+      bool evaluate(const Solution& sol, const Rational& tolerance, double posact, double negact, Rational& viol) const;
+
+      /**
+       * Same as evaluate(), for a solution whose activity in the row is exactly zero
+       */
+      bool evaluateZero(const Rational& tolerance, Rational& viol) const;
+
+      /**
+       * Same as evaluate(), with the activity given exactly
+       * @param posact positive part of the activity
+       * @param negact negative part of the activity
+       */
+      bool evaluateActivity(const Rational& posact, const Rational& negact, const Rational& tolerance, Rational& viol) const;
+
+      /**
+       * Compute check() and violation() in interval arithmetic. The activity, its positive
+       * and negative parts and the relaxed sides are enclosed; the row is certified feasible
+       * or infeasible if the enclosures do not overlap at the relaxed sides, and decided
+       * exactly otherwise.
+       */
+      bool evaluateInterval(const Solution& sol, const Rational& tolerance, Rational& viol) const;
+
+      /**
+       * Compute the activity of the row exactly, and the scale of the tolerance of the side
+       * it violates, max {pospart, negpart, |side|, 1} as in check()
+       * @param activity stores the activity
+       * @param scale stores the scale
+       */
+      void violationScale(const Solution& sol, Rational& activity, Rational& scale) const;
 
       /**
        * Print a description of the constraint (for debugging)
        */
       void print() const;
+
+   protected:
+      /**
+       * Try to decide the row in double precision.
+       * The activity is computed with a rigorous bound on its rounding error;
+       * a property is certified only if it holds by more than that bound.
+       * @param feasible stores if the row satisfies its relaxed sides (check() is true) for sure
+       * @param withinSides stores if the activity is within the sides (violation() is zero) for sure
+       */
+      void checkApprox(const Solution& sol, double tolerance, bool& feasible, bool& withinSides) const;
+
+      /** Same as checkApprox(), for the activity with positive part @param posact and negative part @param negact */
+      void decideApprox(double posact, double negact, double tolerance, bool& feasible, bool& withinSides) const;
+
+      /** Finish evaluate() for the rows not decided by decideApprox() */
+      bool evaluateExact(const Solution& sol, const Rational& tolerance, bool feasible, bool withinSides, Rational& viol) const;
+
+      /** Compute the positive and negative parts of the row activity exactly */
+      void exactActivity(const Solution& sol, Rational& posact, Rational& negact) const;
+
+      /** Compute the sides relaxed by the tolerance used in check() */
+      void relaxedSides(
+            const Rational& posact,
+            const Rational& negact,
+            const Rational& tolerance,
+            Rational& relaxedLhs,
+            Rational& relaxedRhs) const;
+
+      /** Compute the violation of the sides by @param activity */
+      void sidesViolation(const Rational& activity, Rational& viol) const;
 };
 
 /**
@@ -237,18 +494,30 @@ class SOSConstraint:public Constraint
       void push(Var* v);
 
       /**
-       * Check if the constraint is satisfied by the current values of its variables.
+       * Check if the constraint is satisfied by the given values of its variables.
+       * @param sol solution values of the variables
        * @param tolerance tolerance for checking feasibility
        * @return true if the constraint is satisfied, false otherwise.
        */
-      bool check(const Rational& tolerance) const;
+      bool check(const Solution& sol, const Rational& tolerance) const;
 
       /**
        * Calculate the constraint violation
        * Since this is a "combinatorial" constraint, we always return 0 for now...FIXME
        * Return value is in @param viol
        */
-      void violation(Rational& viol) const;
+      void violation(const Solution& sol, Rational& viol) const;
+
+      /**
+       * Compute check() and violation() together, without printing
+       */
+      bool evaluate(const Solution& sol, const Rational& tolerance, Rational& viol) const;
+
+      /**
+       * Same as evaluate(): each value is compared with the tolerance exactly, in a single
+       * comparison that an enclosure would not make cheaper
+       */
+      bool evaluateInterval(const Solution& sol, const Rational& tolerance, Rational& viol) const;
 
       /**
        * Print a description of the constraint (for debugging)
@@ -256,8 +525,8 @@ class SOSConstraint:public Constraint
       void print() const;
 
    protected:
-      bool checkType1(const Rational& tolerance) const;
-      bool checkType2(const Rational& tolerance) const;
+      bool checkType1(const Solution& sol, const Rational& tolerance) const;
+      bool checkType2(const Solution& sol, const Rational& tolerance) const;
 };
 
 
@@ -281,20 +550,30 @@ class IndicatorConstraint:public Constraint
        */
       IndicatorConstraint(const char* _name, Var* _ifvar, bool _ifvalue, Constraint* _thencons);
 
-      ~IndicatorConstraint();
-
       /**
-       * Check if the constraint is satisfied by the current values of its variables.
+       * Check if the constraint is satisfied by the given values of its variables.
+       * @param sol solution values of the variables
        * @param tolerance tolerance for checking feasibility
        * @return true if the constraint is satisfied, false otherwise.
        */
-      bool check(const Rational& tolerance) const;
+      bool check(const Solution& sol, const Rational& tolerance) const;
 
       /**
        * Calculate the constraint violation
        * Return value is in @param viol
        */
-      void violation(Rational& viol) const;
+      void violation(const Solution& sol, Rational& viol) const;
+
+      /**
+       * Compute check() and violation() together, without printing.
+       * The constraint is satisfied and not violated if it is not triggered.
+       */
+      bool evaluate(const Solution& sol, const Rational& tolerance, Rational& viol) const;
+
+      /**
+       * Same as evaluate(), with the consequence decided by its evaluateInterval()
+       */
+      bool evaluateInterval(const Solution& sol, const Rational& tolerance, Rational& viol) const;
 
       /**
        * Print a description of the constraint (for debugging)
@@ -302,11 +581,121 @@ class IndicatorConstraint:public Constraint
       void print() const;
 };
 
+/**
+ * @brief Outcome of checking a solution against a model (see Model::evaluate()).
+ */
+class CheckResult
+{
+   public:
+      /* does the solution satisfy the integrality requirements? */
+      bool intFeasible;
+      /* does the solution satisfy bounds and constraints? */
+      bool linearFeasible;
+      /* is the objective value given by the solver correct? */
+      bool correctObj;
+      /* maximum integrality violation */
+      Rational intViol;
+      /* maximum bound and constraint violation */
+      Rational linearViol;
+      /* violation of the objective value given by the solver (0 if none given) */
+      Rational objViol;
+      /* objective value of the solution, as computed by the checker */
+      Rational objVal;
+      /* position of the first variable failing its bounds or integrality check (-1 if none) */
+      int firstVarFailure;
+      /* position of the first constraint failing its check (-1 if none) */
+      int firstConsFailure;
+
+      /** Constructor */
+      CheckResult();
+};
+
+/**
+ * @brief A violated bound, integrality requirement or constraint (see ViolationReport).
+ */
+class Violation
+{
+   public:
+      /**
+       * @enum Kind what is violated
+       */
+      enum Kind
+      {
+         BOUND,
+         INTEGRALITY,
+         CONSTRAINT
+      };
+      /* what is violated */
+      Kind kind;
+      /* position of the variable or constraint */
+      int index;
+      /* absolute violation */
+      Rational viol;
+      /* value of the variable, or activity of a linear constraint (zero for other constraints) */
+      Rational value;
+      /* scale of the tolerance, the relative violation is viol / scale
+       * (1 for integrality and for constraints that are not linear) */
+      Rational scale;
+      /* absolute violation rounded to double, to rank by */
+      double absViol;
+      /* relative violation rounded to double, to rank by */
+      double relViol;
+};
+
+/**
+ * @brief The K largest violations of a solution, by absolute and by relative measure.
+ * Filled by Model::evaluate() in its single pass over the model: each ranking is a bounded
+ * heap with its smallest entry on top, which a larger violation replaces once K entries are
+ * kept. Violations are ranked by their value rounded to double.
+ */
+class ViolationReport
+{
+   public:
+      /* number of violations to keep per ranking */
+      int k;
+      /* largest absolute violations, as a heap with the smallest on top (see sorted()) */
+      std::vector<Violation> byAbsolute;
+      /* largest relative violations, as a heap with the smallest on top (see sorted()) */
+      std::vector<Violation> byRelative;
+
+      /**
+       * Constructor
+       * @param _k number of violations to keep per ranking
+       */
+      ViolationReport(int _k = 0);
+
+      /**
+       * Tell whether a violation may enter one of the rankings, before its relative violation
+       * is computed: the scale is at least 1, so the relative violation is at most @param absViol
+       */
+      bool mayEnter(double absViol) const;
+
+      /**
+       * Add a violation to the rankings it belongs to. A violation already kept (same kind
+       * and position) is not added again.
+       */
+      void push(const Violation& violation);
+
+      /** Add the violations kept by @param other */
+      void merge(const ViolationReport& other);
+
+      /** Remove all violations */
+      void clear();
+
+      /**
+       * Get the violations of a ranking, largest first
+       * @param relative ranking by relative violation instead of absolute violation?
+       */
+      std::vector<Violation> sorted(bool relative) const;
+};
+
 /**
  * @brief Class representing a MIP problem.
- * Holds the list of variables and constraints of the model.
- * The model owns all variable and constraint objects, and frees
- * them on destruction.
+ * Holds the list of variables and constraints of the model in dense arrays,
+ * together with a hashed name index to look them up.
+ * The model owns all variable and constraint objects: they are created in an arena
+ * with create(), with their names interned in a string pool, and are all released
+ * at once when the model is destroyed.
  */
 class Model
 {
@@ -319,6 +708,14 @@ class Model
          MINIMIZE,
          MAXIMIZE
       };
+      /**
+       * @enum Backend Arithmetic used by evaluate() to decide the constraints
+       */
+      enum Backend
+      {
+         EXACT,     //< floating-point filter, exact arithmetic for the rows it does not decide
+         INTERVAL   //< interval arithmetic, exact arithmetic for the rows it does not decide
+      };
       /* name of the model */
       std::string modelName;
       /* name of the objective function */
@@ -331,44 +728,120 @@ class Model
       Rational objectiveValue;
       /* objective function constant */
       Rational objConstant;
+      /* constraint matrix holding the rows of all linear constraints */
+      SparseMatrix matrix;
+      /* solution values (default is zero) */
+      Solution solution;
+      /* arithmetic used by evaluate() to decide the constraints */
+      Backend backend;
 
       /** Constructor */
       Model();
       /** Destructor */
       ~Model();
 
+      /**
+       * Create a variable or constraint owned by the model.
+       * The object must not be deleted; it lives as long as the model.
+       * @param name name of the object, interned in the model
+       * @param args remaining arguments for the constructor of T
+       */
+      template <class T, class... Args>
+      T* create(const char* name, Args&&... args)
+      {
+         return arena.create<T>(names.intern(name), std::forward<Args>(args)...);
+      }
+
       /**
        * Get a variable by name
        * @return a pointer to the variable with name @param name if found, NULL otherwise
        */
       Var* getVar(const char* name) const;
 
+      /**
+       * Get a variable by its position in the model
+       * @param index position of the variable, in [0, numVars())
+       */
+      Var* getVar(unsigned int index) const;
+
       /**
        * Get a constraint by name
        * @return a pointer to the constraint with name @param name if found, NULL otherwise
        */
       Constraint* getCons(const char* name) const;
 
+      /**
+       * Get a constraint by its position in the model
+       * @param index position of the constraint, in [0, numConss())
+       */
+      Constraint* getCons(unsigned int index) const;
+
       /**
        * Add a variable to the model.
-       * If a variable with the same name exists it is replaced by the new one.
-       * @param var variable to add
+       * If a variable with the same name exists it is replaced by the new one,
+       * which takes over its position.
+       * @param var variable to add, created with create()
        */
       void pushVar(Var* var);
 
       /**
        * Add a constraint to the model
-       * If a constraint with the same name exists it is replaced by the new one.
-       * @param cons constraint to add
+       * If a constraint with the same name exists it is replaced by the new one,
+       * which takes over its position.
+       * @param cons constraint to add, created with create()
        */
       void pushCons(Constraint* cons);
 
       /**
-       * Remove a constraint (if it exists) from the model
+       * Remove a constraint (if it exists) from the model.
+       * The last constraint is moved into the freed position, so positions of
+       * other constraints are not stable across removals.
        * @param name name of the constraint to remove
        */
       void removeCons(const char* name);
 
+      /**
+       * Start a streaming check, on an empty model, for models whose nonzeros do not fit in
+       * memory. The solution is read first with readSol(), keeping its values by name; then,
+       * while the model is read, each variable takes its value when it is created, and the
+       * nonzeros of the linear constraints are not stored but multiplied with the values of
+       * their variables and added up into exact row activities (by positive and negative part).
+       * Memory is thus proportional to the number of rows and columns, not of nonzeros.
+       * The checks work as usual on the streamed activities; other solutions cannot be checked.
+       * Solutions in the CPLEX XML format cannot be streamed.
+       */
+      void startStreaming();
+
+      /** Is this a streaming check (see startStreaming())? */
+      bool isStreaming() const { return streaming; }
+
+      /**
+       * Add a nonzero of a streaming check to the activity of its row
+       * @param row row of the nonzero
+       * @param col column of the nonzero, whose value is already known
+       * @param val coefficient
+       */
+      void streamNonzero(int row, int col, const Rational& val);
+
+      /** Get the activity of @param row accumulated by a streaming check */
+      void streamedActivity(int row, Rational& posact, Rational& negact) const;
+
+      /**
+       * Finish the model after all variables and constraints have been added:
+       * compresses the constraint matrix (unless already done), sizes the solution
+       * and collects what the column-wise evaluation needs.
+       * @return number of solution values of variables not in the model, in a streaming check
+       *         (see reportUnexpectedVars())
+       */
+      int finalize();
+
+      /**
+       * Print the variables of the solution values of a streaming check that are not in the
+       * finalized model, as readSol() prints them when the model is read first
+       * @return number of these variables
+       */
+      int reportUnexpectedVars();
+
       /**
        * Get number of variables
        */
@@ -389,13 +862,106 @@ class Model
        * x2    34.00000 \n
        * ... \n
        *
+       * Variables not listed in the file are zero: values of a previously read
+       * solution are cleared first, so the same model can check several solutions.
+       * Solution files written by CPLEX in its XML format (possibly gzipped) are
+       * recognized by their contents and read with CplexSolInput.
+       *
        * @param filename path to the file with the solution values
        * @return true if successful, false otherwise
        */
       bool readSol(const char* filename);
 
       /**
-       * Check if the model is satisfied by the current values of the variables.
+       * Read all solutions of a solution pool file, without touching the current solution.
+       * In the format of readSol(), a line "=sol= [name]" starts the next solution (the
+       * values before the first one form a solution of their own); in the CPLEX XML format,
+       * each CPLEXSolution element is a solution. Solutions without a variable value are dropped.
+       * @param filename path to the file with the solutions
+       * @param pool stores the solutions read
+       * @return true if some solution was read, false otherwise
+       */
+      bool readSolPool(const char* filename, std::vector<PoolSolution>& pool);
+
+      /**
+       * Check the current solution values in a single pass over variables and
+       * constraints: computes all verdicts and maximum violations together.
+       * There is no early exit. If the support of the solution covers less than half of
+       * the nonzeros of the matrix, row activities are accumulated column-wise over the
+       * support, and only the variables and constraints that can differ from their state
+       * at zero are evaluated; results are the same as when evaluating everything.
+       * Constraints are decided with the arithmetic of backend; the verdicts are the same
+       * with both, violations may be upper bounds with INTERVAL (see Constraint::evaluateInterval()).
+       * Does not print anything, see reportFailures().
+       * @param intTolerance tolerance for integrality check
+       * @param linearTolerance tolerance for constraint (and bound) checks and
+       * for comparing the real objective value with the one given by the solver (if any)
+       * @param result stores verdicts and violations
+       * @param nthreads number of threads to spread variables and constraints over
+       * @param profile stores the time of each phase of the check (if not NULL)
+       * @param report stores the largest violations (if not NULL), see ViolationReport
+       */
+      void evaluate(
+            const Rational& intTolerance,
+            const Rational& linearTolerance,
+            CheckResult& result,
+            int nthreads = 1,
+            Profile* profile = NULL,
+            ViolationReport* report = NULL) const;
+
+      /**
+       * Same as evaluate(), for the solution values @param sol instead of the current ones.
+       * Neither the model nor its current solution is touched, so several solutions can be
+       * checked concurrently, each with its own @param scratch.
+       * @param reportedObjective objective value of the solution as reported by the solver (NULL if none)
+       */
+      void evaluate(
+            const Solution& sol,
+            const Rational* reportedObjective,
+            const Rational& intTolerance,
+            const Rational& linearTolerance,
+            CheckResult& result,
+            int nthreads,
+            ColumnActivity& scratch,
+            Profile* profile = NULL,
+            ViolationReport* report = NULL) const;
+
+      /**
+       * Set the objective value and its verdict in @param result, as evaluate() does
+       * @param objValPlus sum of the positive terms of the objective function
+       * @param objValMinus sum of the negative terms of the objective function
+       * @param reportedObjective objective value as reported by the solver (NULL if none)
+       * @param linearTolerance tolerance for comparing the objective value with the one given by the solver
+       */
+      void checkObjective(
+            const Rational& objValPlus,
+            const Rational& objValMinus,
+            const Rational* reportedObjective,
+            const Rational& linearTolerance,
+            CheckResult& result) const;
+
+      /**
+       * Print the failures found by evaluate(): the first failing variable,
+       * the first failing constraint and a wrong objective value.
+       */
+      void reportFailures(
+            const CheckResult& result,
+            const Rational& intTolerance,
+            const Rational& linearTolerance) const;
+
+      /**
+       * Print the largest violations found by evaluate(): for each ranking, the name of the
+       * variable or constraint, its value or activity, its bounds or sides, the absolute and
+       * relative violation and the tolerance it is compared with. Only the data kept in the
+       * report and the violated variables and constraints themselves are looked at.
+       */
+      void reportViolations(
+            const ViolationReport& report,
+            const Rational& intTolerance,
+            const Rational& linearTolerance) const;
+
+      /**
+       * Check if the model is satisfied by the current solution values.
        * Checks both domains and linear constraints.
        * Check correctness of objective value
        * @param intTolerance tolerance for integrality check
@@ -404,22 +970,26 @@ class Model
        * @param intFeasible stores if the solution satisfies the integrality requirements
        * @param linearFeasible stores if the solution satisfies the linear constraints
        * @param correctObj stores if the objective value computed by the solver is correct
+       * @param nthreads number of threads to spread variables and constraints over
        */
       void check(
             const Rational& intTolerance,
             const Rational& linearTolerance,
             bool& intFeasible,
             bool& linearFeasible,
-            bool& correctObj) const;
+            bool& correctObj,
+            int nthreads = 1) const;
 
       /**
        * Calculate the maximum integrality, linear and objective violations with the
-       * current values of the variables
+       * current solution values
+       * @param nthreads number of threads to spread variables and constraints over
        */
       void maxViolations(
             Rational& intViol,
             Rational& linearViol,
-            Rational& objViol) const;
+            Rational& objViol,
+            int nthreads = 1) const;
 
       /**
        * Print the model (for debugging)
@@ -431,10 +1001,48 @@ class Model
        */
       void printSol() const;
    protected:
-      /* set of variables */
-      std::map<std::string, Var*> vars;
-      /* set of constraints */
-      std::map<std::string, Constraint*> conss;
+      /* memory of the variables and constraints */
+      Arena arena;
+      /* interned names of the variables and constraints */
+      StringPool names;
+      /* variables, indexed by their position */
+      std::vector<Var*> vars;
+      /* constraints, indexed by their position */
+      std::vector<Constraint*> conss;
+      /* pooled name -> position index (names are compared by address, see StringPool) */
+      typedef std::unordered_map<const char*, int> NameIndex;
+      /* name -> position index of the variables */
+      NameIndex varIndex;
+      /* name -> position index of the constraints */
+      NameIndex consIndex;
+      /* row in the matrix of each constraint (-1 if not a linear constraint) */
+      std::vector<int> consRow;
+      /* constraint of each row of the matrix (-1 if none, e.g. for the consequence of an indicator) */
+      std::vector<int> rowCons;
+      /* positions of the variables that violate their bounds at value zero */
+      std::vector<int> zeroViolatedVars;
+      /* positions of the linear constraints violated at zero activity, to evaluate even if
+       * no variable of the support appears in their row */
+      std::vector<int> zeroCheckedConss;
+      /* positions of the constraints that are not linear (SOS and indicator), evaluated on their own */
+      std::vector<int> otherConss;
+      /* scratch of evaluate() on the current solution (which must thus not run concurrently) */
+      mutable ColumnActivity activity;
+      /* is this a streaming check (see startStreaming())? */
+      bool streaming;
+      /* solution values of a streaming check whose variables have not been read yet,
+       * with the position of their first line in the solution file */
+      std::unordered_map<std::string, std::pair<Rational, int> > pendingValues;
+      /* positive parts of the row activities of a streaming check */
+      std::vector<Rational> streamedPosact;
+      /* negative parts of the row activities of a streaming check */
+      std::vector<Rational> streamedNegact;
+
+      /**
+       * Read a solution file (see readSol() and readSolPool())
+       * @param pool stores all solutions of the file, or NULL to read the first one into the current solution
+       */
+      bool readSolFile(const char* filename, std::vector<PoolSolution>* pool);
 };
 
 #endif
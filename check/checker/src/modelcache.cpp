@@ -0,0 +1,488 @@
+/**
+ * @file modelcache.cpp
+ * @brief Binary cache of parsed MIP models
+ */
+
+#include "modelcache.h"
+#include "model.h"
+#include "hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+
+#define CACHE_MAGIC       "SOLCHKMC"
+#define CACHE_VERSION     1
+#define CACHE_SUFFIX      ".smc"
+#define HASH_BLOCKSIZE    (1 << 20)
+
+/* kinds of constraints in a cache file */
+enum CacheConsKind
+{
+   CACHE_LINEAR,
+   CACHE_SOS,
+   CACHE_INDICATOR
+};
+
+/* header of a cache file, followed by the string table and the model data */
+struct CacheHeader
+{
+   char magic[8];
+   uint32_t version;
+   /* size of a GMP limb, the limbs are stored raw */
+   uint32_t limbBytes;
+   /* content hash and size of the MPS file the model was read from */
+   uint64_t sourceHash;
+   uint64_t sourceSize;
+   /* size of the whole cache file */
+   uint64_t fileSize;
+   /* size of the string table */
+   uint64_t namesSize;
+};
+
+/* hash the content of a file; returns false if the file cannot be read */
+static bool hashFile(const char* filename, uint64_t& hash, uint64_t& size)
+{
+   FILE* fp = fopen(filename, "rb");
+   if( fp == NULL )
+      return false;
+   std::vector<unsigned char> block(HASH_BLOCKSIZE);
+   hash = HASH_SEED;
+   size = 0;
+   size_t len;
+   while( (len = fread(&block[0], 1, block.size(), fp)) > 0 )
+   {
+      hash = hashBytes(hash, &block[0], len);
+      size += len;
+   }
+   bool success = !ferror(fp);
+   fclose(fp);
+   return success;
+}
+
+/* serializes a model: names go to an interned string table, everything else to the data */
+class CacheWriter
+{
+   public:
+      std::string names;
+      std::vector<char> data;
+
+      void put(const void* ptr, size_t len)
+      {
+         size_t pos = data.size();
+         data.resize(pos + len);
+         memcpy(&data[pos], ptr, len);
+      }
+
+      void putInt(int32_t val)
+      {
+         put(&val, sizeof(val));
+      }
+
+      void putInts(const std::vector<int>& vals)
+      {
+         if( !vals.empty() )
+            put(&vals[0], vals.size() * sizeof(int));
+      }
+
+      void putName(const std::string& name)
+      {
+         std::unordered_map<std::string, int32_t>::const_iterator itr = offsets.find(name);
+         if( itr != offsets.end() )
+         {
+            putInt(itr->second);
+            return;
+         }
+         int32_t offset = names.size();
+         names.append(name.c_str(), name.size() + 1);
+         offsets[name] = offset;
+         putInt(offset);
+      }
+
+      void putRational(const Rational& val)
+      {
+         int numSize;
+         int denSize;
+         val.limbSizes(numSize, denSize);
+         putInt(numSize);
+         putInt(denSize);
+         limbs.resize(abs(numSize) + denSize);
+         val.toLimbs(&limbs[0]);
+         put(&limbs[0], limbs.size() * sizeof(mp_limb_t));
+      }
+
+      void putRationals(const std::vector<Rational>& vals)
+      {
+         for( unsigned int i = 0; i < vals.size(); ++i )
+            putRational(vals[i]);
+      }
+
+      void putLinear(const LinearConstraint* cons)
+      {
+         putName(cons->name);
+         putInt(cons->lintype);
+         putInt(cons->row);
+      }
+
+   protected:
+      std::unordered_map<std::string, int32_t> offsets;
+      std::vector<mp_limb_t> limbs;
+};
+
+/* reads back what CacheWriter wrote; every read is bounds checked and failures are sticky */
+class CacheReader
+{
+   public:
+      bool ok;
+
+      CacheReader(const char* _names, size_t _namesSize, const char* _pos, const char* _end)
+         :ok(_namesSize > 0 && _names[_namesSize - 1] == '\0'), names(_names), namesSize(_namesSize), pos(_pos), end(_end) {}
+
+      void get(void* ptr, size_t len)
+      {
+         if( !ok || (size_t)(end - pos) < len )
+         {
+            ok = false;
+            memset(ptr, 0, len);
+            return;
+         }
+         memcpy(ptr, pos, len);
+         pos += len;
+      }
+
+      int32_t getInt()
+      {
+         int32_t val;
+         get(&val, sizeof(val));
+         return val;
+      }
+
+      /* read an int in [0, bound) */
+      int getIndex(int bound)
+      {
+         int32_t val = getInt();
+         if( val < 0 || val >= bound )
+         {
+            ok = false;
+            return 0;
+         }
+         return val;
+      }
+
+      void getInts(std::vector<int>& vals, size_t n)
+      {
+         if( (size_t)(end - pos) / sizeof(int) < n )
+            ok = false;
+         if( !ok )
+            n = 0;
+         vals.resize(n);
+         if( n > 0 )
+            get(&vals[0], n * sizeof(int));
+      }
+
+      const char* getName()
+      {
+         int32_t offset = getInt();
+         if( offset < 0 || (size_t)offset >= namesSize )
+         {
+            ok = false;
+            return "";
+         }
+         return names + offset;
+      }
+
+      void getRational(Rational& val)
+      {
+         int32_t numSize = getInt();
+         int32_t denSize = getInt();
+         if( !ok || denSize <= 0 || numSize < -INT32_MAX || (size_t)(end - pos) / sizeof(mp_limb_t) < (size_t)abs(numSize) + denSize )
+         {
+            ok = false;
+            return;
+         }
+         limbs.resize(abs(numSize) + denSize);
+         get(&limbs[0], limbs.size() * sizeof(mp_limb_t));
+         val.fromLimbs(numSize, denSize, &limbs[0]);
+      }
+
+      void getRationals(std::vector<Rational>& vals, size_t n)
+      {
+         /* a rational takes at least its two sizes and one limb */
+         if( (size_t)(end - pos) / (2 * sizeof(int32_t) + sizeof(mp_limb_t)) < n )
+            ok = false;
+         if( !ok )
+            n = 0;
+         vals.resize(n);
+         for( size_t i = 0; i < n && ok; ++i )
+            getRational(vals[i]);
+      }
+
+      LinearConstraint* getLinear(Model* model)
+      {
+         const char* name = getName();
+         int lintype = getIndex(LinearConstraint::RANGED + 1);
+         int row = getIndex(model->matrix.numRows());
+         if( !ok )
+            return NULL;
+         return model->create<LinearConstraint>(name, (LinearConstraint::LinearType)lintype, model, row);
+      }
+
+   protected:
+      const char* names;
+      size_t namesSize;
+      const char* pos;
+      const char* end;
+      std::vector<mp_limb_t> limbs;
+};
+
+/* fill an empty model from the model data of a cache file */
+static bool readModel(CacheReader& reader, Model* model)
+{
+   model->modelName = reader.getName();
+   model->objName = reader.getName();
+   model->objSense = (Model::ObjSense)reader.getIndex(Model::MAXIMIZE + 1);
+   reader.getRational(model->objConstant);
+
+   /* variables */
+   int nvars = reader.getIndex(INT32_MAX);
+   Rational lb;
+   Rational ub;
+   Rational obj;
+   for( int i = 0; i < nvars && reader.ok; ++i )
+   {
+      const char* name = reader.getName();
+      int type = reader.getIndex(Var::CONTINUOUS + 1);
+      reader.getRational(lb);
+      reader.getRational(ub);
+      reader.getRational(obj);
+      if( reader.ok )
+         model->pushVar(model->create<Var>(name, (Var::VarType)type, lb, ub, obj));
+   }
+   if( !reader.ok || (int)model->numVars() != nvars )
+      return false;
+
+   /* constraint matrix */
+   SparseMatrix& matrix = model->matrix;
+   int nrows = reader.getIndex(INT32_MAX);
+   int nnz = reader.getIndex(INT32_MAX);
+   reader.getInts(matrix.rowBeg, nrows + 1);
+   reader.getInts(matrix.rowInd, nnz);
+   reader.getRationals(matrix.lhs, nrows);
+   reader.getRationals(matrix.rhs, nrows);
+   reader.getRationals(matrix.rowVal, nnz);
+   if( !reader.ok || matrix.rowBeg[0] != 0 || matrix.rowBeg[nrows] != nnz )
+      return false;
+   for( int i = 0; i < nrows; ++i )
+   {
+      if( matrix.rowBeg[i] > matrix.rowBeg[i + 1] )
+         return false;
+   }
+   for( int k = 0; k < nnz; ++k )
+   {
+      if( matrix.rowInd[k] < 0 || matrix.rowInd[k] >= nvars )
+         return false;
+   }
+
+   /* constraints */
+   int nconss = reader.getIndex(INT32_MAX);
+   for( int i = 0; i < nconss && reader.ok; ++i )
+   {
+      int kind = reader.getIndex(CACHE_INDICATOR + 1);
+      if( kind == CACHE_LINEAR )
+      {
+         LinearConstraint* cons = reader.getLinear(model);
+         if( cons != NULL )
+            model->pushCons(cons);
+      }
+      else if( kind == CACHE_SOS )
+      {
+         const char* name = reader.getName();
+         int sostype = reader.getIndex(SOSConstraint::TYPE_2 + 1);
+         int nmembers = reader.getIndex(nvars + 1);
+         if( !reader.ok )
+            break;
+         SOSConstraint* cons = model->create<SOSConstraint>(name, (SOSConstraint::SOSType)sostype);
+         for( int k = 0; k < nmembers; ++k )
+            cons->push(model->getVar(reader.getIndex(nvars)));
+         model->pushCons(cons);
+      }
+      else
+      {
+         const char* name = reader.getName();
+         int ifvar = reader.getIndex(nvars);
+         int ifvalue = reader.getIndex(2);
+         LinearConstraint* thencons = reader.getLinear(model);
+         if( thencons != NULL )
+            model->pushCons(model->create<IndicatorConstraint>(name, model->getVar(ifvar), ifvalue == 1, thencons));
+      }
+   }
+   if( !reader.ok || (int)model->numConss() != nconss )
+      return false;
+
+   matrix.buildIndex(nvars);
+   model->finalize();
+   return true;
+}
+
+ModelCache::ModelCache(const char* _directory)
+   :directory(_directory), sourceHash(0), sourceSize(0) {}
+
+bool ModelCache::load(const char* mpsfile, Model* model)
+{
+   assert( mpsfile != NULL );
+   assert( model != NULL );
+   assert( model->numVars() == 0 && model->numConss() == 0 );
+
+   /* find the cache file of the MPS file */
+   path.clear();
+   if( !hashFile(mpsfile, sourceHash, sourceSize) )
+      return false;
+   char key[32];
+   snprintf(key, sizeof(key), "%016llx", (unsigned long long)sourceHash);
+   path = directory + "/" + key + CACHE_SUFFIX;
+
+   int fd = open(path.c_str(), O_RDONLY);
+   if( fd < 0 )
+      return false;
+   struct stat st;
+   if( fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CacheHeader) )
+   {
+      close(fd);
+      return false;
+   }
+   size_t fileSize = st.st_size;
+   void* addr = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if( addr == MAP_FAILED )
+      return false;
+   madvise(addr, fileSize, MADV_SEQUENTIAL);
+
+   /* check that the cache file is complete and was written for this MPS file and build */
+   const char* base = (const char*)addr;
+   CacheHeader header;
+   memcpy(&header, base, sizeof(header));
+   bool success = !memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic))
+      && header.version == CACHE_VERSION
+      && header.limbBytes == sizeof(mp_limb_t)
+      && header.sourceHash == sourceHash
+      && header.sourceSize == sourceSize
+      && header.fileSize == fileSize
+      && header.namesSize <= fileSize - sizeof(header);
+
+   if( success )
+   {
+      const char* names = base + sizeof(header);
+      CacheReader reader(names, header.namesSize, names + header.namesSize, base + fileSize);
+      success = readModel(reader, model);
+   }
+
+   munmap(addr, fileSize);
+   return success;
+}
+
+bool ModelCache::store(const Model* model)
+{
+   assert( model != NULL );
+   if( path.empty() )
+      return false;
+
+   /* serialize the model */
+   CacheWriter writer;
+   writer.putName(model->modelName);
+   writer.putName(model->objName);
+   writer.putInt(model->objSense);
+   writer.putRational(model->objConstant);
+
+   writer.putInt(model->numVars());
+   for( unsigned int i = 0; i < model->numVars(); ++i )
+   {
+      const Var* var = model->getVar(i);
+      writer.putName(var->name);
+      writer.putInt(var->type);
+      writer.putRational(var->lb);
+      writer.putRational(var->ub);
+      writer.putRational(var->objCoef);
+   }
+
+   const SparseMatrix& matrix = model->matrix;
+   assert( matrix.isCompressed() );
+   writer.putInt(matrix.numRows());
+   writer.putInt(matrix.numNonzeros());
+   writer.putInts(matrix.rowBeg);
+   writer.putInts(matrix.rowInd);
+   writer.putRationals(matrix.lhs);
+   writer.putRationals(matrix.rhs);
+   writer.putRationals(matrix.rowVal);
+
+   writer.putInt(model->numConss());
+   for( unsigned int i = 0; i < model->numConss(); ++i )
+   {
+      const Constraint* cons = model->getCons(i);
+      const LinearConstraint* lincons = dynamic_cast<const LinearConstraint*>(cons);
+      const SOSConstraint* soscons = dynamic_cast<const SOSConstraint*>(cons);
+      const IndicatorConstraint* indcons = dynamic_cast<const IndicatorConstraint*>(cons);
+      if( lincons != NULL )
+      {
+         writer.putInt(CACHE_LINEAR);
+         writer.putLinear(lincons);
+      }
+      else if( soscons != NULL )
+      {
+         writer.putInt(CACHE_SOS);
+         writer.putName(soscons->name);
+         writer.putInt(soscons->sostype);
+         writer.putInt(soscons->vars.size());
+         for( unsigned int k = 0; k < soscons->vars.size(); ++k )
+            writer.putInt(soscons->vars[k]->index);
+      }
+      else if( indcons != NULL && dynamic_cast<const LinearConstraint*>(indcons->thencons) != NULL )
+      {
+         writer.putInt(CACHE_INDICATOR);
+         writer.putName(indcons->name);
+         writer.putInt(indcons->ifvar->index);
+         writer.putInt(indcons->ifvalue);
+         writer.putLinear(static_cast<const LinearConstraint*>(indcons->thencons));
+      }
+      else
+      {
+         /* constraint not supported by the cache */
+         return false;
+      }
+   }
+
+   CacheHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+   header.version = CACHE_VERSION;
+   header.limbBytes = sizeof(mp_limb_t);
+   header.sourceHash = sourceHash;
+   header.sourceSize = sourceSize;
+   header.namesSize = writer.names.size();
+   header.fileSize = sizeof(header) + writer.names.size() + writer.data.size();
+
+   /* write under a temporary name, then move into place */
+   if( mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST )
+      return false;
+   char suffix[32];
+   snprintf(suffix, sizeof(suffix), ".tmp.%d", (int)getpid());
+   std::string tmppath = path + suffix;
+   FILE* fp = fopen(tmppath.c_str(), "wb");
+   if( fp == NULL )
+      return false;
+   bool success = fwrite(&header, sizeof(header), 1, fp) == 1
+      && fwrite(writer.names.data(), 1, writer.names.size(), fp) == writer.names.size()
+      && (writer.data.empty() || fwrite(&writer.data[0], 1, writer.data.size(), fp) == writer.data.size());
+   success = (fclose(fp) == 0) && success;
+   if( success )
+      success = (rename(tmppath.c_str(), path.c_str()) == 0);
+   if( !success )
+      unlink(tmppath.c_str());
+   return success;
+}
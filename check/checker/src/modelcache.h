@@ -0,0 +1,61 @@
+/**
+ * @file modelcache.h
+ * @brief Binary cache of parsed MIP models
+ */
+
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include <stdint.h>
+#include <string>
+
+class Model;
+
+/**
+ * @brief Binary cache of parsed models, so that repeated checks of the same instance
+ * do not need to read and parse its MPS file again.
+ * Cache files live in a directory and are named after a content hash of the MPS file
+ * (of the file as stored, i.e. compressed if it is gzipped). A cache file holds the
+ * names in a single string table, the constraint matrix in CSR form and every number
+ * as an exact rational in raw GMP limbs. Cache files are memory-mapped when loaded.
+ * They are written under a temporary name and then renamed, so that concurrent jobs
+ * sharing a cache directory never see partial files.
+ */
+class ModelCache
+{
+   public:
+      /**
+       * Constructor
+       * @param _directory directory holding the cache files (created if missing)
+       */
+      ModelCache(const char* _directory);
+
+      /**
+       * Load the model of an MPS file from the cache.
+       * Also remembers the key of the MPS file for a later store().
+       * @param mpsfile path to the MPS file (may be gzipped)
+       * @param model empty model to fill
+       * @return true if the model was found in the cache, false otherwise
+       * (the model may then be partially filled and must be discarded)
+       */
+      bool load(const char* mpsfile, Model* model);
+
+      /**
+       * Store a model in the cache, under the key of the MPS file given to the last load().
+       * @param model model read from that MPS file
+       * @return true if successful, false otherwise
+       */
+      bool store(const Model* model);
+
+   protected:
+      /* directory holding the cache files */
+      std::string directory;
+      /* path of the cache file of the current MPS file (empty if unknown) */
+      std::string path;
+      /* content hash of the current MPS file */
+      uint64_t sourceHash;
+      /* size in bytes of the current MPS file */
+      uint64_t sourceSize;
+};
+
+#endif
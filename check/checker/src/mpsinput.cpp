@@ -5,38 +5,141 @@
 
 #include "mpsinput.h"
 #include "model.h"
+#include "parallel.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
 #include <assert.h>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 
 #define MPS_MIN_LINELEN   80
+#define MPS_BLOCKSIZE     (1 << 22)
+#define MPS_MAX_READ      (1 << 30)
+#define MPS_GZBUFFER      (1 << 18)
 #define MPS_MAX_NAMELEN   256
 #define PATCH_CHAR        '_'
 #define BLANK             ' '
 #define INFBOUND          1e20
+#define MPS_THREADCHUNKS  4
 
-/* fill the line from \p pos up to column MPS_MIN_LINELEN with blanks. */
-static void clearFrom(
-      char*                 buf,
+/* part of the COLUMNS section, parsed by one thread */
+struct MpsInput::ColumnsChunk
+{
+   /* a column starting in the part */
+   struct Column
+   {
+      const char* name; //< name of the column, in the input block
+      int integer; //< is the column in an integer block (-1 if no marker is in the part before it)?
+      size_t beg; //< position of its first entry in cons and values
+   };
+
+   size_t beg; //< start of the first line of the part in the input
+   size_t end; //< end of the part: start of the line after its last one
+   bool hasHeader; //< does the next section start in the part (then end is its first line)?
+   bool hasFreeLine; //< has the part a line that is not in fixed format?
+   bool startsFree; //< is the format known to be free at the start of the part?
+   int nlines; //< number of lines of the part
+   int errorLine; //< line of a malformed entry, counted in the part (-1 if none)
+   int endInteger; //< is the end of the part in an integer block (-1 if the part has no marker)?
+   std::vector<Column> columns; //< columns starting in the part, in file order
+   std::vector<LinearConstraint*> cons; //< row of each entry (NULL for the objective)
+   std::vector<Rational> values; //< coefficient of each entry
+
+   ColumnsChunk():beg(0), end(0), hasHeader(false), hasFreeLine(false), startsFree(false),
+      nlines(0), errorLine(-1), endInteger(-1) {}
+};
+
+/* character at position \p pos of a line of length \p len, which is padded with blanks
+ * up to column MPS_MIN_LINELEN (and beyond). Tabs and carriage returns count as blanks. */
+static char charAt(
+      const char*           line,
+      unsigned int          len,
       unsigned int          pos
       )
 {
-   for( unsigned int i = pos; i < MPS_MIN_LINELEN; ++i )
-      buf[i] = BLANK;
-   buf[MPS_MIN_LINELEN] = '\0';
+   if( pos >= len )
+      return BLANK;
+   char c = line[pos];
+   return (c == '\t' || c == '\r') ? BLANK : c;
+}
+
+/* length of a data line of length \p len without its fixed format comment, which starts
+ * with a '$' in column 15 or 40. */
+static unsigned int fixedFormatLength(
+      const char*           line,
+      unsigned int          len
+      )
+{
+   if( (charAt(line, len, 14) == '$') && (charAt(line, len, 13) == BLANK) )
+      return 14;
+   if( (charAt(line, len, 39) == '$') && (charAt(line, len, 38) == BLANK) )
+      return 39;
+   return len;
+}
+
+/* test whether a data line of length \p len (without comment) is in fixed format, where
+ * \p linelen is its length including the newline. Returns 1 if it is, -1 if there are
+ * blanks at the right positions but no number where it should be, and 0 otherwise. */
+static int fixedFormatTest(
+      const char*           line,
+      unsigned int          len,
+      unsigned int          linelen
+      )
+{
+   int space = charAt(line, len, 12) | charAt(line, len, 13)
+      | charAt(line, len, 22) | charAt(line, len, 23)
+      | charAt(line, len, 36) | charAt(line, len, 37) | charAt(line, len, 38)
+      | charAt(line, len, 47) | charAt(line, len, 48)
+      | charAt(line, len, 61) | charAt(line, len, 62) | charAt(line, len, 63);
+   if( space != BLANK )
+      return 0;
+
+   /* Now we have space at the right positions.
+    * But are there also the non space where they
+    * should be ?
+    */
+   int number = 0;
+   for( unsigned int i = 24; i <= 35 && !number; ++i )
+      number = isdigit(charAt(line, len, i));
+
+   /* len < 13 is handle ROW lines with embedded spaces
+    * in the names correctly
+    */
+   return (number || linelen < 13) ? 1 : -1;
+}
+
+/* start of the first line at or after position \p pos of the unread input data[start, end) */
+static size_t lineStart(
+      const char*           data,
+      size_t                start,
+      size_t                end,
+      size_t                pos
+      )
+{
+   if( pos <= start )
+      return start;
+   if( pos >= end )
+      return end;
+   const char* nl = (const char*)memchr(data + pos - 1, '\n', end - pos + 1);
+   return nl == NULL ? end : nl - data + 1;
 }
 
 /* change all blanks inside a field to #PATCH_CHAR. */
 static void patchField(
       char*                 buf,
+      int                   len,
       int                   beg,
       int                   end
       )
 {
+   /* the padding beyond the line is blank, so it is trimmed anyway */
+   if( end >= len )
+      end = len - 1;
+
    while( (beg <= end) && (buf[end] == BLANK) )
       end--;
 
@@ -48,7 +151,25 @@ static void patchField(
          buf[i] = PATCH_CHAR;
 }
 
-MpsInput::MpsInput()
+/* split off the next blank separated token starting at \p pos, terminating it in place.
+ * Returns NULL if there is no token left. */
+static char* nextToken(
+      char*&                pos
+      )
+{
+   while( *pos == BLANK )
+      ++pos;
+   if( *pos == '\0' )
+      return NULL;
+   char* tok = pos;
+   while( *pos != BLANK && *pos != '\0' )
+      ++pos;
+   if( *pos == BLANK )
+      *pos++ = '\0';
+   return tok;
+}
+
+MpsInput::MpsInput(int _nthreads)
 {
    section     = MPS_NAME;
    model       = NULL;
@@ -56,9 +177,14 @@ MpsInput::MpsInput()
    gzfp        = NULL;
    isZipped    = false;
    linenu      = 0;
+   data        = NULL;
+   blockPos    = 0;
+   blockEnd    = 0;
+   blockEof    = false;
    isInteger   = false;
    isFreeFormat = false;
-   buf[0]      = '\0';
+   nmarkers    = 0;
+   nthreads    = _nthreads;
    f0          = NULL;
    f1          = NULL;
    f2          = NULL;
@@ -67,12 +193,103 @@ MpsInput::MpsInput()
    f5          = NULL;
 }
 
-/* read a mps format data line and parse the fields. */
+/* move the unread data to the front of the block and read more input behind it.
+ * The block grows if a single line does not fit. Returns false at the end of the input. */
+bool MpsInput::fillBlock()
+{
+   if( blockEof )
+      return false;
+
+   size_t rest = blockEnd - blockPos;
+   if( rest > 0 && blockPos > 0 )
+      memmove(&block[0], &block[blockPos], rest);
+   blockPos = 0;
+   blockEnd = rest;
+   if( blockEnd + 1 >= block.size() )
+      block.resize(2 * block.size());
+   data = &block[0];
+
+   /* keep one byte to terminate a last line without newline */
+   size_t space = std::min(block.size() - 1 - blockEnd, (size_t)MPS_MAX_READ);
+   size_t nread;
+   if( isZipped )
+   {
+      int ret = gzread(gzfp, &block[blockEnd], space);
+      nread = (ret > 0 ? ret : 0);
+   }
+   else
+      nread = fread(&block[blockEnd], 1, space, fp);
+
+   if( nread == 0 )
+      blockEof = true;
+   blockEnd += nread;
+   return nread > 0;
+}
+
+/* read all input into the block, so that parts of it can be parsed concurrently */
+void MpsInput::readAll()
+{
+   /* plain files are read at once */
+   if( !isZipped && fseek(fp, 0, SEEK_END) == 0 )
+   {
+      long size = ftell(fp);
+      if( fseek(fp, 0, SEEK_SET) != 0 )
+         return;
+      /* room for the termination, and to find the end without growing the block */
+      if( size > 0 && (size_t)size + 2 > block.size() )
+      {
+         block.resize(size + 2);
+         data = &block[0];
+      }
+   }
+   while( fillBlock() )
+      ;
+}
+
+/* get the next raw line of input, terminated in place; \p len is its length without
+ * the newline and \p newline tells whether there was one. Returns false at the end of the input. */
+bool MpsInput::nextLine(
+      char*&                line,
+      unsigned int&         len,
+      bool&                 newline
+      )
+{
+   while( true )
+   {
+      char* beg = data + blockPos;
+      char* nl = (char*)memchr(beg, '\n', blockEnd - blockPos);
+      if( nl != NULL )
+      {
+         *nl = '\0';
+         line = beg;
+         len = nl - beg;
+         newline = true;
+         blockPos += len + 1;
+         return true;
+      }
+      if( !fillBlock() )
+      {
+         if( blockPos == blockEnd )
+            return false;
+         line = data + blockPos;
+         len = blockEnd - blockPos;
+         line[len] = '\0';
+         newline = false;
+         blockPos = blockEnd;
+         return true;
+      }
+   }
+}
+
+/* read a mps format data line and parse the fields.
+ * Fields point into the input block and stay valid until the next call. */
 bool MpsInput::readLine()
 {
    bool isMarker;
    bool isEmpty;
-   char* nexttok;
+   char* buf;
+   unsigned int len;
+   bool newline;
 
    do
    {
@@ -80,45 +297,29 @@ bool MpsInput::readLine()
       isMarker = false;
 
       /* Read until we have a not comment line. */
-      if( isZipped )
-      {
-         do
-         {
-            memset((void*)buf, 0, MPS_MAX_LINELEN);
-            if( gzgets(gzfp, buf, sizeof(buf)) == NULL )
-               return false;
-            linenu++;
-         }
-         while( buf[0] == '*' );
-      }
-      else
+      do
       {
-         do
-         {
-            memset((void*)buf, 0, MPS_MAX_LINELEN);
-            if ( fgets(buf, sizeof(buf), fp) == NULL )
-               return false;
-            linenu++;
-         }
-         while( buf[0] == '*' );
+         if( !nextLine(buf, len, newline) )
+            return false;
+         linenu++;
       }
+      while( buf[0] == '*' );
 
       /* Normalize line */
-      unsigned int len = strlen(buf);
       for( unsigned int i = 0; i < len; i++ )
       {
-         if( (buf[i] == '\t') || (buf[i] == '\n') || (buf[i] == '\r') )
+         if( (buf[i] == '\t') || (buf[i] == '\r') )
             buf[i] = BLANK;
       }
-      if( len < MPS_MIN_LINELEN )
-         clearFrom(buf, len);
-      assert(strlen(buf) >= MPS_MIN_LINELEN);
+      /* length as counted by the fixed format test, including the newline */
+      unsigned int linelen = len + (newline ? 1 : 0);
 
       /* Look for new section */
-      if( buf[0] != BLANK )
+      if( charAt(buf, len, 0) != BLANK )
       {
-         f0 = strtok_r(buf, " ", &nexttok);
-         f1 = strtok_r(NULL, " ", &nexttok);
+         char* nexttok = buf;
+         f0 = nextToken(nexttok);
+         f1 = nextToken(nexttok);
          return true;
       }
 
@@ -126,53 +327,28 @@ bool MpsInput::readLine()
       if( !isFreeFormat )
       {
          /* Test for fixed format comments */
-         if( (buf[14] == '$') && (buf[13] == ' ') )
-            clearFrom(buf, 14);
-         else if( (buf[39] == '$') && (buf[38] == ' ') )
-            clearFrom(buf, 39);
+         unsigned int fixedlen = fixedFormatLength(buf, len);
+         if( fixedlen < len )
+         {
+            buf[fixedlen] = '\0';
+            len = fixedlen;
+         }
 
          /* Test for fixed format */
-         int space = buf[12] | buf[13]
-            | buf[22] | buf[23]
-            | buf[36] | buf[37] | buf[38]
-            | buf[47] | buf[48]
-            | buf[61] | buf[62] | buf[63];
-
-         if ( space == BLANK )
+         int fixed = fixedFormatTest(buf, len, linelen);
+         if( fixed > 0 )
          {
-            /* Now we have space at the right positions.
-             * But are there also the non space where they
-             * should be ?
-             */
-            int number = isdigit(buf[24]) || isdigit(buf[25])
-               || isdigit(buf[26]) || isdigit(buf[27])
-               || isdigit(buf[28]) || isdigit(buf[29])
-               || isdigit(buf[30]) || isdigit(buf[31])
-               || isdigit(buf[32]) || isdigit(buf[33])
-               || isdigit(buf[34]) || isdigit(buf[35]);
-
-            /* len < 13 is handle ROW lines with embedded spaces
-             * in the names correctly
-             */
-            if( number || len < 13 )
-            {
-               /* We assume fixed format, so we patch possible embedded spaces. */
-               patchField(buf,  4, 12);
-               patchField(buf, 14, 22);
-               patchField(buf, 39, 47);
-            }
-            else
-            {
-               if( section == MPS_COLUMNS || section == MPS_RHS || section == MPS_RANGES  || section == MPS_BOUNDS )
-                  isFreeFormat = true;
-            }
+            /* We assume fixed format, so we patch possible embedded spaces. */
+            patchField(buf, len,  4, 12);
+            patchField(buf, len, 14, 22);
+            patchField(buf, len, 39, 47);
          }
-         else
-         {
+         else if( fixed == 0 )
+            isFreeFormat = true;
+         else if( section == MPS_COLUMNS || section == MPS_RHS || section == MPS_RANGES  || section == MPS_BOUNDS )
             isFreeFormat = true;
-         }
       }
-      char* s = &buf[1];
+      char* nexttok = (len > 0 ? &buf[1] : buf);
 
       /* At this point it is not clear if we have a indicator field.
        * If there is none (e.g. empty) f1 will be the first name field.
@@ -185,10 +361,10 @@ bool MpsInput::readLine()
        */
       do
       {
-         if( NULL == (f1 = strtok_r(s, " ", &nexttok)) )
+         if( NULL == (f1 = nextToken(nexttok)) )
             break;
 
-         if( (NULL == (f2 = strtok_r(NULL, " ", &nexttok))) || (*f2 == '$') )
+         if( (NULL == (f2 = nextToken(nexttok))) || (*f2 == '$') )
          {
             f2 = 0;
             break;
@@ -196,7 +372,7 @@ bool MpsInput::readLine()
          if( !strcmp(f2, "'MARKER'") )
             isMarker = true;
 
-         if( (NULL == (f3 = strtok_r(NULL, " ", &nexttok))) || (*f3 == '$') )
+         if( (NULL == (f3 = nextToken(nexttok))) || (*f3 == '$') )
          {
             f3 = 0;
             break;
@@ -209,11 +385,12 @@ bool MpsInput::readLine()
                isInteger = false;
             else
                break; /* unknown marker */
+            nmarkers++;
          }
          if( !strcmp(f3, "'MARKER'") )
             isMarker = true;
 
-         if( (NULL == (f4 = strtok_r(NULL, " ", &nexttok))) || (*f4 == '$') )
+         if( (NULL == (f4 = nextToken(nexttok))) || (*f4 == '$') )
          {
             f4 = 0;
             break;
@@ -226,8 +403,9 @@ bool MpsInput::readLine()
                isInteger = false;
             else
                break; /* unknown marker */
+            nmarkers++;
          }
-         if( (NULL == (f5 = strtok_r(NULL, " ", &nexttok))) || (*f5 == '$') )
+         if( (NULL == (f5 = nextToken(nexttok))) || (*f5 == '$') )
             f5 = 0;
       }
       while( false );
@@ -396,7 +574,7 @@ void MpsInput::readRows()
                printf("Read MPS file error! Line %d\n", linenu);
          }
 
-         model->pushCons(new LinearConstraint(f2, ctype, clb, cub));
+         model->pushCons(model->create<LinearConstraint>(f2, ctype, model, clb, cub));
       }
    }
    printf("Read MPS file error! Line %d\n", linenu);
@@ -405,7 +583,14 @@ void MpsInput::readRows()
 /* Process COLUMNS section. */
 void MpsInput::readCols()
 {
-   char colname[MPS_MAX_NAMELEN] = { '\0' };
+   Var* var = NULL;
+
+   /* with all input in memory, the section is parsed concurrently up to the next section */
+   if( nthreads > 1 && blockEof && !readColsParallel(var) )
+   {
+      printf("Read MPS file error! Line %d\n", linenu);
+      return;
+   }
 
    while( readLine() )
    {
@@ -420,28 +605,27 @@ void MpsInput::readCols()
          break;
 
       /* new column */
-      if( strcmp(colname, f1) )
+      if( var == NULL || strcmp(var->name, f1) )
       {
-         (void)strncpy(colname, f1, MPS_MAX_NAMELEN - 1);
 
          if( isInteger )
          {
             /* for integer variables, default bounds are 0 <= x , and default cost is 0 */
-            model->pushVar(new Var(colname, Var::INTEGER, 0.0, INFBOUND, 0.0));
+            var = model->create<Var>(f1, Var::INTEGER, 0.0, INFBOUND, 0.0);
          }
          else
          {
             /* for continuous variables, default bounds are 0 <= x, and default cost is 0 */
-            model->pushVar(new Var(colname, Var::CONTINUOUS, 0.0, INFBOUND, 0.0));
+            var = model->create<Var>(f1, Var::CONTINUOUS, 0.0, INFBOUND, 0.0);
          }
+         model->pushVar(var);
       }
 
-      Var* var = model->getVar(colname);
       assert( var != NULL );
       Rational val;
       val.fromString(f3);
 
-      if( std::string(f2) == model->objName )
+      if( !strcmp(f2, model->objName.c_str()) )
          var->objCoef = val;
       else
       {
@@ -456,7 +640,7 @@ void MpsInput::readCols()
 
          val.fromString(f5);
 
-         if( std::string(f4) == model->objName )
+         if( !strcmp(f4, model->objName.c_str()) )
             var->objCoef = val;
          else
          {
@@ -470,6 +654,173 @@ void MpsInput::readCols()
    printf("Read MPS file error! Line %d\n", linenu);
 }
 
+/* Parse the COLUMNS section concurrently, up to the first line of the next section,
+ * and add the columns to the model in file order; \p var is the last column added.
+ * The unread input is split into parts at line boundaries. A first pass over the parts
+ * finds the end of the section and the lines that switch to free format, so that each part
+ * starts with the format the lines before it have set; the second pass parses the parts.
+ * A column cut in two by the split is joined again when adding the columns, and the
+ * integer markers of a part apply to the columns after them. Returns false if a line is
+ * malformed (linenu is its line then), with the columns before it added. */
+bool MpsInput::readColsParallel(
+      Var*&                 var
+      )
+{
+   size_t start = blockPos;
+   size_t nchunks = (size_t)MPS_THREADCHUNKS * nthreads;
+   size_t chunksize = (blockEnd - start) / nchunks + 1;
+   std::vector<ColumnsChunk> chunks(nchunks);
+   for( size_t k = 0; k < nchunks; ++k )
+   {
+      chunks[k].beg = lineStart(data, start, blockEnd, start + k * chunksize);
+      chunks[k].end = lineStart(data, start, blockEnd, start + (k + 1) * chunksize);
+   }
+
+   /* find the first line of the next section, and which parts have lines in free format */
+   std::atomic<size_t> sectionEnd(blockEnd);
+   parallelFor(nchunks, 1, nthreads, [&](unsigned int k, unsigned int, int)
+   {
+      ColumnsChunk& chunk = chunks[k];
+      size_t pos = chunk.beg;
+      while( pos < chunk.end && pos < sectionEnd.load() )
+      {
+         const char* line = data + pos;
+         const char* nl = (const char*)memchr(line, '\n', chunk.end - pos);
+         unsigned int len = (nl != NULL ? nl - line : chunk.end - pos);
+         if( line[0] != '*' )
+         {
+            if( charAt(line, len, 0) != BLANK )
+            {
+               chunk.end = pos;
+               chunk.hasHeader = true;
+               size_t end = sectionEnd.load();
+               while( pos < end && !sectionEnd.compare_exchange_weak(end, pos) )
+                  ;
+               break;
+            }
+            if( !isFreeFormat && !chunk.hasFreeLine
+               && fixedFormatTest(line, fixedFormatLength(line, len), len + (nl != NULL ? 1 : 0)) <= 0 )
+               chunk.hasFreeLine = true;
+         }
+         pos += len + 1;
+      }
+   });
+   size_t nparts = 0;
+   while( nparts < nchunks && !chunks[nparts++].hasHeader )
+      ;
+   chunks.resize(nparts);
+   bool freeFormat = isFreeFormat;
+   for( size_t k = 0; k < nparts; ++k )
+   {
+      chunks[k].startsFree = freeFormat;
+      freeFormat = freeFormat || chunks[k].hasFreeLine;
+   }
+
+   /* parse the parts */
+   parallelFor(nparts, 1, nthreads, [&](unsigned int k, unsigned int, int)
+   {
+      MpsInput worker;
+      worker.model = model;
+      worker.data = data;
+      worker.blockPos = chunks[k].beg;
+      worker.blockEnd = chunks[k].end;
+      worker.blockEof = true;
+      worker.section = MPS_COLUMNS;
+      worker.isFreeFormat = chunks[k].startsFree;
+      worker.readColsChunk(chunks[k]);
+   });
+
+   /* add the columns in file order */
+   size_t nentries = 0;
+   for( size_t k = 0; k < nparts; ++k )
+      nentries += chunks[k].values.size();
+   model->matrix.reserve(nentries);
+   for( size_t k = 0; k < nparts; ++k )
+   {
+      ColumnsChunk& chunk = chunks[k];
+      for( size_t c = 0; c < chunk.columns.size(); ++c )
+      {
+         const ColumnsChunk::Column& column = chunk.columns[c];
+         if( var == NULL || strcmp(var->name, column.name) )
+         {
+            bool integer = (column.integer >= 0 ? column.integer > 0 : isInteger);
+            /* default bounds are 0 <= x, and default cost is 0 */
+            var = model->create<Var>(column.name, integer ? Var::INTEGER : Var::CONTINUOUS, 0.0, INFBOUND, 0.0);
+            model->pushVar(var);
+         }
+         size_t end = (c + 1 < chunk.columns.size() ? chunk.columns[c + 1].beg : chunk.values.size());
+         for( size_t e = column.beg; e < end; ++e )
+         {
+            if( chunk.cons[e] == NULL )
+               var->objCoef = chunk.values[e];
+            else
+               chunk.cons[e]->push(var, chunk.values[e]);
+         }
+      }
+      if( chunk.errorLine >= 0 )
+      {
+         linenu += chunk.errorLine;
+         return false;
+      }
+      linenu += chunk.nlines;
+      if( chunk.endInteger >= 0 )
+         isInteger = (chunk.endInteger > 0);
+      nmarkers += (chunk.endInteger >= 0);
+   }
+   isFreeFormat = freeFormat;
+   blockPos = (nparts > 0 ? chunks[nparts - 1].end : start);
+   return true;
+}
+
+/* Parse the lines between blockPos and blockEnd of the COLUMNS section into \p chunk
+ * (in a worker reader, see readColsParallel()). Free rows other than the objective are skipped. */
+void MpsInput::readColsChunk(
+      ColumnsChunk&         chunk
+      )
+{
+   const char* colname = NULL;
+
+   auto addEntry = [&](const char* rowname, const char* value)
+   {
+      LinearConstraint* cons = NULL;
+      if( strcmp(rowname, model->objName.c_str()) )
+      {
+         cons = static_cast<LinearConstraint*>(model->getCons(rowname));
+         if( cons == NULL )
+            return;
+      }
+      chunk.cons.push_back(cons);
+      chunk.values.push_back(Rational());
+      chunk.values.back().fromString(value);
+   };
+
+   while( readLine() )
+   {
+      if( f1 == NULL || f2 == NULL || f3 == NULL )
+      {
+         chunk.errorLine = linenu;
+         return;
+      }
+
+      /* new column */
+      if( colname == NULL || strcmp(colname, f1) )
+      {
+         ColumnsChunk::Column column = { f1, nmarkers > 0 ? (int)isInteger : -1, chunk.values.size() };
+         chunk.columns.push_back(column);
+         colname = f1;
+      }
+
+      addEntry(f2, f3);
+      if( f5 != NULL )
+      {
+         assert( f4 != NULL );
+         addEntry(f4, f5);
+      }
+   }
+   chunk.nlines = linenu;
+   chunk.endInteger = (nmarkers > 0 ? (int)isInteger : -1);
+}
+
 /* Process RHS section. */
 void MpsInput::readRhs()
 {
@@ -511,14 +862,14 @@ void MpsInput::readRhs()
       switch(cons->lintype)
       {
          case LinearConstraint::LESS_THAN:
-            cons->rhs = val;
+            cons->rhs() = val;
             break;
          case LinearConstraint::GREATER_THAN:
-            cons->lhs = val;
+            cons->lhs() = val;
             break;
          case LinearConstraint::EQUAL:
-            cons->lhs = val;
-            cons->rhs = val;
+            cons->lhs() = val;
+            cons->rhs() = val;
             break;
          default:
             printf("Read MPS file error! Line %d\n", linenu);
@@ -536,14 +887,14 @@ void MpsInput::readRhs()
          switch(cons->lintype)
          {
             case LinearConstraint::LESS_THAN:
-               cons->rhs = val;
+               cons->rhs() = val;
                break;
             case LinearConstraint::GREATER_THAN:
-               cons->lhs = val;
+               cons->lhs() = val;
                break;
             case LinearConstraint::EQUAL:
-               cons->lhs = val;
-               cons->rhs = val;
+               cons->lhs() = val;
+               cons->rhs() = val;
                break;
             default:
                printf("Read MPS file error! Line %d\n", linenu);
@@ -603,17 +954,17 @@ void MpsInput::readRanges()
          {
             case LinearConstraint::LESS_THAN:
                val.abs();
-               sub(cons->lhs, cons->rhs, val);
+               sub(cons->lhs(), cons->rhs(), val);
                break;
             case LinearConstraint::GREATER_THAN:
                val.abs();
-               add(cons->rhs, cons->lhs, val);
+               add(cons->rhs(), cons->lhs(), val);
                break;
             case LinearConstraint::EQUAL:
                if (val.isPositive())
-                  cons->rhs += val;
+                  cons->rhs() += val;
                else
-                  cons->lhs += val;
+                  cons->lhs() += val;
                break;
             default:
                printf("Read MPS file error! Line %d\n", linenu);
@@ -628,17 +979,17 @@ void MpsInput::readRanges()
             {
                case LinearConstraint::LESS_THAN:
                   val.abs();
-                  sub(cons->lhs, cons->rhs, val);
+                  sub(cons->lhs(), cons->rhs(), val);
                   break;
                case LinearConstraint::GREATER_THAN:
                   val.abs();
-                  add(cons->rhs, cons->lhs, val);
+                  add(cons->rhs(), cons->lhs(), val);
                   break;
                case LinearConstraint::EQUAL:
                   if (val.isPositive())
-                     cons->rhs += val;
+                     cons->rhs() += val;
                   else
-                     cons->lhs += val;
+                     cons->lhs() += val;
                   break;
                default:
                   printf("Read MPS file error! Line %d\n", linenu);
@@ -811,9 +1162,9 @@ void MpsInput::readSOS()
             (void)snprintf(sosname, MPS_MAX_NAMELEN, "SOS%d", ++cnt);
          /* create SOS constraint */
          if( type == 1 )
-            model->pushCons(new SOSConstraint(sosname, SOSConstraint::TYPE_1));
+            model->pushCons(model->create<SOSConstraint>(sosname, SOSConstraint::TYPE_1));
          else if( type == 2 )
-            model->pushCons(new SOSConstraint(sosname, SOSConstraint::TYPE_2));
+            model->pushCons(model->create<SOSConstraint>(sosname, SOSConstraint::TYPE_2));
       }
       else
       {
@@ -866,7 +1217,7 @@ void MpsInput::readIndicators()
       model->removeCons(f2);
 
       /* Add indicator constraint */
-      model->pushCons(new IndicatorConstraint(f2, ifvar, ifval == one, thencons));
+      model->pushCons(model->create<IndicatorConstraint>(f2, ifvar, ifval == one, thencons));
    }
    printf("Read MPS file error! Line %d\n", linenu);
 }
@@ -902,6 +1253,7 @@ bool MpsInput::readMps(
          printf("Cannot open file <%s> for reading\n", _filename);
          return false;
       }
+      gzbuffer(gzfp, MPS_GZBUFFER);
    }
    else
    {
@@ -915,6 +1267,14 @@ bool MpsInput::readMps(
    assert( fp != NULL || gzfp != NULL );
 
    model = _model;
+   block.resize(MPS_BLOCKSIZE);
+   data = &block[0];
+   blockPos = 0;
+   blockEnd = 0;
+   blockEof = false;
+   linenu = 0;
+   if( nthreads > 1 )
+      readAll();
 
    readName();
 
@@ -940,7 +1300,10 @@ bool MpsInput::readMps(
    if( section != MPS_ENDATA )
       printf("Read MPS file error! Line %d\n", linenu);
 
+   model->finalize();
    model = NULL;
+   std::vector<char>().swap(block);
+   data = NULL;
 
    if( isZipped )
    {
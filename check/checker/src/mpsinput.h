@@ -7,24 +7,34 @@
 #define MPSINPUT_H
 
 #include <string>
+#include <vector>
 #include <stdexcept>
 #include <stdio.h>
 #include <zlib.h>
 
-#define MPS_MAX_LINELEN  1024
-
 class Model;
+class Var;
 
 /**
  * @brief MPS reader class.
  * It reads an MPS file (possibly gzipped), both in the old fixed length format
  * and in the new "relaxed" format. It handles all basic extensions.
+ * Input is read in large blocks; lines are tokenized in place in the block,
+ * so fields are not copied and lines can have any length.
+ * With several threads, the whole input is read into memory first (gzipped files are
+ * inflated), and the COLUMNS section is split into parts at line boundaries that are
+ * parsed concurrently into column fragments; the fragments are then added to the model
+ * in file order, so the model is the same as when read with a single thread.
  * It does NOT handle SOS and quadratic stuff yet!
  */
 class MpsInput
 {
    public:
-      MpsInput();
+      /**
+       * Constructor
+       * @param _nthreads number of threads to parse the COLUMNS section with
+       */
+      MpsInput(int _nthreads = 1);
       /**
        * @brief reads an MPS file
        * @param _filename path to the MPS file (may be gzipped)
@@ -51,13 +61,20 @@ class MpsInput
          MPS_ENDATA
       };
 
+      /* part of the COLUMNS section parsed by one thread (see readColsParallel()) */
+      struct ColumnsChunk;
+
       MpsSection    section; //< current section of the MPS section
       Model*        model; //< model to fill
       FILE*         fp; //< FILE pointer for plain MPS files
       gzFile        gzfp; //< gzFile pointer for gzipped files
       bool          isZipped; //< are we reading from a gzipped file?
       int           linenu; //< current line number
-      char          buf[MPS_MAX_LINELEN]; //< buffer to store and manipulate each line of input
+      std::vector<char> block; //< block of input data, lines are tokenized in place
+      char*         data; //< start of the input data: the block, or the block of the reader a worker parses a part of
+      size_t        blockPos; //< start of the next line in the block
+      size_t        blockEnd; //< end of the data read into the block
+      bool          blockEof; //< has all input been read into the block?
       const char*   f0; //< field 0 of an MPS line
       const char*   f1; //< field 1 of an MPS line
       const char*   f2; //< field 2 of an MPS line
@@ -66,7 +83,12 @@ class MpsInput
       const char*   f5; //< field 5 of an MPS line
       bool          isInteger; //< is the current variable in a integer block?
       bool          isFreeFormat; //< is this a free format MPS file?
+      int           nmarkers; //< number of integer markers read
+      int           nthreads; //< number of threads to parse the COLUMNS section with
 
+      bool fillBlock();
+      void readAll();
+      bool nextLine(char*& line, unsigned int& len, bool& newline);
       bool readLine();
       void insertName(const char* name, bool second);
       void readName();
@@ -74,6 +96,8 @@ class MpsInput
       void readObjname();
       void readRows();
       void readCols();
+      bool readColsParallel(Var*& var);
+      void readColsChunk(ColumnsChunk& chunk);
       void readRhs();
       void readRanges();
       void readBounds();
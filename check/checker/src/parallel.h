@@ -0,0 +1,48 @@
+/**
+ * @file parallel.h
+ * @brief Helper to spread loops over threads
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * Call func(begin, end, thread) on consecutive chunks [begin, end) of [0, n),
+ * each of size at most @param chunk. Chunks are handed out dynamically to
+ * @param nthreads threads, the calling thread included; thread is the index of
+ * the calling thread in [0, nthreads) and may be used to address per-thread data.
+ * With one thread (or a single chunk) func is called once on [0, n) by the calling thread.
+ */
+template <class Func>
+void parallelFor(unsigned int n, unsigned int chunk, int nthreads, Func func)
+{
+   if( nthreads <= 1 || n <= chunk )
+   {
+      func(0u, n, 0);
+      return;
+   }
+   std::atomic<unsigned int> next(0);
+   auto worker = [&](int thread)
+   {
+      while( true )
+      {
+         unsigned int begin = next.fetch_add(chunk);
+         if( begin >= n )
+            break;
+         func(begin, std::min(n, begin + chunk), thread);
+      }
+   };
+   std::vector<std::thread> threads;
+   for( int t = 1; t < nthreads; ++t )
+      threads.push_back(std::thread(worker, t));
+   worker(0);
+   for( unsigned int t = 0; t < threads.size(); ++t )
+      threads[t].join();
+}
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file profile.h
+ * @brief Timing and memory profile of the phases of a check
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+
+/**
+ * @brief Wall-clock time and peak resident memory of the phases of a check.
+ * Phases are timed with a monotonic high-resolution clock; the peak resident set size
+ * of the process is sampled at the end of each phase, so it is the high-water mark up
+ * to that point. Time spent in a phase several times is added up.
+ * A phase served from the cache of a checker daemon (see CheckServer) has no peak memory:
+ * the model is the daemon's, not of the process checking; it is printed as "cached":true.
+ * The profile is printed as a single JSON line, e.g.
+ * {"profile":"solchecker","phases":{"parse":{"seconds":0.5,"peak_rss_kb":1024},...},"total":{...}}
+ */
+class Profile
+{
+   public:
+      /** Constructor, starts the total time */
+      Profile():current(-1), started(Clock::now()) {}
+
+      /** Start phase @param name (a literal, compared by contents), ending the current one */
+      void begin(const char* name)
+      {
+         end();
+         current = find(name);
+         phaseStart = Clock::now();
+      }
+
+      /**
+       * Start phase @param name at @param start, before the call (e.g. when a checker daemon accepted
+       * the request), ending the current one; the total time then also starts there if earlier
+       */
+      void begin(const char* name, std::chrono::steady_clock::time_point start)
+      {
+         begin(name);
+         phaseStart = start;
+         if( start < started )
+            started = start;
+      }
+
+      /** End the current phase, if any */
+      void end()
+      {
+         if( current < 0 )
+            return;
+         phases[current].seconds += std::chrono::duration<double>(Clock::now() - phaseStart).count();
+         phases[current].peakRss = peakRss();
+         current = -1;
+      }
+
+      /** End the current phase, if any, as served from the cache of a checker daemon */
+      void endCached()
+      {
+         if( current < 0 )
+            return;
+         phases[current].cached = true;
+         phases[current].seconds += std::chrono::duration<double>(Clock::now() - phaseStart).count();
+         current = -1;
+      }
+
+      /** End the current phase and print the profile as a single JSON line */
+      void print()
+      {
+         end();
+         std::string line = "{\"profile\":\"solchecker\",\"phases\":{";
+         char buf[128];
+         for( unsigned int i = 0; i < phases.size(); ++i )
+         {
+            if( phases[i].cached )
+               snprintf(buf, sizeof(buf), "%s\"%s\":{\"seconds\":%.6f,\"cached\":true}",
+                  i > 0 ? "," : "", phases[i].name, phases[i].seconds);
+            else
+               snprintf(buf, sizeof(buf), "%s\"%s\":{\"seconds\":%.6f,\"peak_rss_kb\":%ld}",
+                  i > 0 ? "," : "", phases[i].name, phases[i].seconds, phases[i].peakRss);
+            line += buf;
+         }
+         snprintf(buf, sizeof(buf), "},\"total\":{\"seconds\":%.6f,\"peak_rss_kb\":%ld}}",
+            std::chrono::duration<double>(Clock::now() - started).count(), peakRss());
+         line += buf;
+         printf("%s\n", line.c_str());
+      }
+
+      /** Peak resident set size of the process so far, in KB */
+      static long peakRss()
+      {
+         struct rusage usage;
+         if( getrusage(RUSAGE_SELF, &usage) != 0 )
+            return 0;
+         return usage.ru_maxrss;
+      }
+
+   protected:
+      typedef std::chrono::steady_clock Clock;
+
+      /* time and memory of a phase */
+      struct Phase
+      {
+         const char* name;
+         double seconds;
+         long peakRss;
+         /* served from the cache of a checker daemon (no peak memory)? */
+         bool cached;
+      };
+
+      /* phases, in the order they were first started */
+      std::vector<Phase> phases;
+      /* position of the running phase (-1 if none) */
+      int current;
+      /* start of the profile */
+      Clock::time_point started;
+      /* start of the running phase */
+      Clock::time_point phaseStart;
+
+      /* position of phase @param name, added if new */
+      int find(const char* name)
+      {
+         for( unsigned int i = 0; i < phases.size(); ++i )
+         {
+            if( strcmp(phases[i].name, name) == 0 )
+               return i;
+         }
+         Phase phase = { name, 0.0, 0, false };
+         phases.push_back(phase);
+         return phases.size() - 1;
+      }
+};
+
+#endif
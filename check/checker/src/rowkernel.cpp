@@ -0,0 +1,76 @@
+/**
+ * @file rowkernel.cpp
+ * @brief Double precision row activity kernels, vectorized where the CPU allows it
+ */
+
+#include "rowkernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ROWKERNEL_X86
+#endif
+
+void rowActivityScalar(const double* val, const int* ind, const double* x, int n, double& posact, double& negact)
+{
+   posact = 0.0;
+   negact = 0.0;
+   for( int k = 0; k < n; ++k )
+   {
+      double prod = val[k] * x[ind[k]];
+      if( prod > 0.0 )
+         posact += prod;
+      else
+         negact += prod;
+   }
+}
+
+#ifdef ROWKERNEL_X86
+__attribute__((target("avx2")))
+void rowActivityAvx2(const double* val, const int* ind, const double* x, int n, double& posact, double& negact)
+{
+   const __m256d zero = _mm256_setzero_pd();
+   __m256d pos = zero;
+   __m256d neg = zero;
+   int k = 0;
+   for( ; k + 4 <= n; k += 4 )
+   {
+      __m128i idx = _mm_loadu_si128((const __m128i*)(ind + k));
+      __m256d prod = _mm256_mul_pd(_mm256_loadu_pd(val + k), _mm256_i32gather_pd(x, idx, 8));
+      /* max and min return their second operand if one is NaN, so NaN is kept */
+      pos = _mm256_add_pd(pos, _mm256_max_pd(zero, prod));
+      neg = _mm256_add_pd(neg, _mm256_min_pd(zero, prod));
+   }
+   /* add up the lanes, and the remaining products in order */
+   double lanes[4];
+   _mm256_storeu_pd(lanes, pos);
+   posact = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+   _mm256_storeu_pd(lanes, neg);
+   negact = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+   double tailpos;
+   double tailneg;
+   rowActivityScalar(val + k, ind + k, x, n - k, tailpos, tailneg);
+   posact += tailpos;
+   negact += tailneg;
+}
+
+bool cpuHasAvx2()
+{
+   return __builtin_cpu_supports("avx2");
+}
+#else
+void rowActivityAvx2(const double* val, const int* ind, const double* x, int n, double& posact, double& negact)
+{
+   rowActivityScalar(val, ind, x, n, posact, negact);
+}
+
+bool cpuHasAvx2()
+{
+   return false;
+}
+#endif
+
+RowActivityKernel rowActivityKernel()
+{
+   static const RowActivityKernel kernel = (cpuHasAvx2() ? rowActivityAvx2 : rowActivityScalar);
+   return kernel;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file rowkernel.h
+ * @brief Double precision row activity kernels, vectorized where the CPU allows it
+ */
+
+#ifndef ROWKERNEL_H
+#define ROWKERNEL_H
+
+/**
+ * Kernel accumulating the positive and negative parts of the products val[k] * x[ind[k]]
+ * for k in [0, n) into @param posact and @param negact (which are set, not added to).
+ * A NaN product makes the activity posact + negact NaN, so that comparisons with it fail.
+ * The order of the additions depends on the kernel; the error bound of the filtered
+ * checks only depends on the number of products.
+ */
+typedef void (*RowActivityKernel)(const double* val, const int* ind, const double* x, int n, double& posact, double& negact);
+
+/** Scalar kernel, summing the products in order */
+void rowActivityScalar(const double* val, const int* ind, const double* x, int n, double& posact, double& negact);
+
+/**
+ * AVX2 kernel: four products at a time, the values of x are gathered by index.
+ * Must only be called if cpuHasAvx2().
+ */
+void rowActivityAvx2(const double* val, const int* ind, const double* x, int n, double& posact, double& negact);
+
+/** Does the CPU we run on support AVX2? */
+bool cpuHasAvx2();
+
+/** Fastest kernel the CPU supports, chosen once at the first call */
+RowActivityKernel rowActivityKernel();
+
+#endif
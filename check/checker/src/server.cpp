@@ -0,0 +1,626 @@
+/**
+ * @file server.cpp
+ * @brief Checker daemon keeping parsed models in memory, and its client
+ */
+
+#include "server.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define SERVER_MAGIC       "SOLCHECKER 2"
+#define SERVER_MAXREQUEST  (1 << 16)
+/* last line of every report, so that the client can tell a complete report from a cut one */
+#define SERVER_END         "=SOLCHECKER END="
+/* seconds a client has to send its request */
+#define SERVER_TIMEOUT     10
+
+typedef std::chrono::steady_clock Clock;
+
+/* what a holder tells the dispatcher once it has read its model */
+struct HolderReport
+{
+   /* could the model be read? */
+   int ok;
+   /* memory used by the model, in bytes */
+   size_t memory;
+};
+
+/* bytes of heap in use, 0 if unknown */
+static size_t heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+   struct mallinfo2 info = mallinfo2();
+   return info.uordblks + info.hblkhd;
+#else
+   return 0;
+#endif
+}
+
+/* rough size of a model in memory, if it cannot be measured */
+static size_t estimateMemory(const Model* model)
+{
+   return (size_t)model->matrix.numNonzeros() * 64 + (size_t)model->numVars() * 160 + (size_t)model->numConss() * 160;
+}
+
+/* set a socket address for @param path; false if the path is too long */
+static bool socketAddress(const char* path, struct sockaddr_un& addr)
+{
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   if( strlen(path) >= sizeof(addr.sun_path) )
+      return false;
+   strcpy(addr.sun_path, path);
+   return true;
+}
+
+/* write all of @param len bytes; false on error */
+static bool writeAll(int fd, const char* buf, size_t len)
+{
+   while( len > 0 )
+   {
+      ssize_t n = write(fd, buf, len);
+      if( n < 0 && errno == EINTR )
+         continue;
+      if( n <= 0 )
+         return false;
+      buf += n;
+      len -= n;
+   }
+   return true;
+}
+
+/* parse a fraction "num/den" or a decimal number */
+static void parseRational(const char* str, Rational& val)
+{
+   const char* slash = strchr(str, '/');
+   if( slash == NULL )
+   {
+      val.fromString(str);
+      return;
+   }
+   std::string num(str, slash - str);
+   Rational den;
+   val.fromString(num.c_str());
+   den.fromString(slash + 1);
+   if( !den.isZero() )
+      div(val, val, den);
+}
+
+/* split a request into its lines; false if it is not complete */
+static bool parseRequest(const std::string& request, std::vector<std::string>& fields)
+{
+   fields.clear();
+   size_t pos = 0;
+   while( fields.size() < 6 )
+   {
+      size_t end = request.find('\n', pos);
+      if( end == std::string::npos )
+         return false;
+      fields.push_back(request.substr(pos, end - pos));
+      pos = end + 1;
+   }
+   return true;
+}
+
+CheckServer::CheckServer(const char* _socketPath, size_t _memoryLimit, int _idleTimeout, ReadFunc _readModel, CheckFunc _check)
+   :socketPath(_socketPath), memoryLimit(_memoryLimit), idleTimeout(_idleTimeout), readModel(_readModel), check(_check),
+    listenFd(-1), memoryUsed(0) {}
+
+CheckServer::~CheckServer()
+{
+   while( !holders.empty() )
+      retire(holders.begin());
+   for( std::list<Connection>::iterator conn = connections.begin(); conn != connections.end(); ++conn )
+      close(conn->fd);
+}
+
+bool CheckServer::run()
+{
+   struct sockaddr_un addr;
+   if( !socketAddress(socketPath.c_str(), addr) )
+   {
+      printf("socket path <%s> is too long\n", socketPath.c_str());
+      return false;
+   }
+   listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if( listenFd < 0 )
+   {
+      printf("cannot create socket: %s\n", strerror(errno));
+      return false;
+   }
+   if( bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 )
+   {
+      /* the socket file may be left over by a daemon that is gone */
+      int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      bool alive = (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+      bool stale = (!alive && errno == ECONNREFUSED);
+      if( fd >= 0 )
+         close(fd);
+      if( !stale || unlink(socketPath.c_str()) != 0
+         || bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 )
+      {
+         printf("cannot listen on <%s>%s\n", socketPath.c_str(), alive ? ": another daemon serves it" : "");
+         close(listenFd);
+         listenFd = -1;
+         return false;
+      }
+   }
+   if( listen(listenFd, 128) != 0 )
+   {
+      printf("cannot listen on <%s>: %s\n", socketPath.c_str(), strerror(errno));
+      close(listenFd);
+      listenFd = -1;
+      return false;
+   }
+
+   /* children are reaped automatically; clients may go away before their report is written */
+   signal(SIGCHLD, SIG_IGN);
+   signal(SIGPIPE, SIG_IGN);
+   printf("serving on <%s>\n", socketPath.c_str());
+   fflush(stdout);
+
+   Clock::time_point lastRequest = Clock::now();
+   while( true )
+   {
+      /* the listening socket, then the connections, then the holders */
+      std::vector<struct pollfd> pfds;
+      struct pollfd pfd;
+      pfd.events = POLLIN;
+      pfd.fd = listenFd;
+      pfds.push_back(pfd);
+      for( std::list<Connection>::iterator conn = connections.begin(); conn != connections.end(); ++conn )
+      {
+         pfd.fd = conn->fd;
+         pfds.push_back(pfd);
+      }
+      bool waiting = false;
+      for( std::list<Holder>::iterator holder = holders.begin(); holder != holders.end(); ++holder )
+      {
+         pfd.fd = holder->fd;
+         pfds.push_back(pfd);
+         waiting = waiting || !holder->waiting.empty();
+      }
+
+      /* wake up when the oldest request is due, or when idle for too long */
+      Clock::time_point now = Clock::now();
+      int timeout = -1;
+      if( !connections.empty() )
+         timeout = std::chrono::duration_cast<std::chrono::milliseconds>(connections.front().arrival + std::chrono::seconds(SERVER_TIMEOUT) - now).count();
+      else if( !waiting && idleTimeout > 0 )
+         timeout = std::chrono::duration_cast<std::chrono::milliseconds>(lastRequest + std::chrono::seconds(idleTimeout) - now).count();
+      if( timeout < -1 )
+         timeout = 0;
+      int ready = poll(&pfds[0], pfds.size(), timeout);
+      if( ready < 0 && errno == EINTR )
+         continue;
+      if( ready < 0 )
+         break;
+      now = Clock::now();
+      if( ready == 0 && connections.empty() && !waiting && idleTimeout > 0 && now - lastRequest >= std::chrono::seconds(idleTimeout) )
+         break;
+
+      /* holders reporting their model, or gone (ready holders do not write) */
+      for( size_t i = 1 + connections.size(); i < pfds.size(); ++i )
+      {
+         if( pfds[i].revents == 0 )
+            continue;
+         for( std::list<Holder>::iterator holder = holders.begin(); holder != holders.end(); ++holder )
+         {
+            if( holder->fd != pfds[i].fd )
+               continue;
+            if( holder->ready )
+               retire(holder);
+            else
+               holderReady(holder);
+            break;
+         }
+      }
+
+      /* read the requests, dispatch the complete ones and drop those that are due */
+      std::list<Connection>::iterator conn = connections.begin();
+      for( size_t i = 1; conn != connections.end(); ++i )
+      {
+         std::vector<std::string> fields;
+         bool keep = (pfds[i].revents == 0 || receive(*conn));
+         if( keep && parseRequest(conn->request, fields) )
+            dispatch(*conn);
+         else if( keep && now - conn->arrival < std::chrono::seconds(SERVER_TIMEOUT) )
+         {
+            ++conn;
+            continue;
+         }
+         else
+            close(conn->fd);
+         conn = connections.erase(conn);
+      }
+
+      if( pfds[0].revents != 0 )
+      {
+         Connection newConn;
+         newConn.fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK);
+         newConn.arrival = now;
+         if( newConn.fd >= 0 )
+         {
+            connections.push_back(newConn);
+            lastRequest = now;
+         }
+      }
+   }
+
+   close(listenFd);
+   listenFd = -1;
+   unlink(socketPath.c_str());
+   printf("idle for %d seconds, stopping\n", idleTimeout);
+   return true;
+}
+
+bool CheckServer::receive(Connection& conn)
+{
+   char buf[4096];
+   while( true )
+   {
+      ssize_t n = read(conn.fd, buf, sizeof(buf));
+      if( n < 0 && errno == EINTR )
+         continue;
+      if( n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+         return true;
+      if( n < 0 )
+         return false;
+      if( n == 0 )
+      {
+         /* closed: only a complete request is answered */
+         std::vector<std::string> fields;
+         return parseRequest(conn.request, fields);
+      }
+      conn.request.append(buf, n);
+      if( conn.request.size() >= SERVER_MAXREQUEST )
+         return false;
+   }
+}
+
+void CheckServer::dispatch(Connection& conn)
+{
+   std::vector<std::string> fields;
+   parseRequest(conn.request, fields);
+   if( fields[0] != SERVER_MAGIC )
+   {
+      close(conn.fd);
+      return;
+   }
+   /* the report is written with blocking writes */
+   fcntl(conn.fd, F_SETFL, fcntl(conn.fd, F_GETFL) & ~O_NONBLOCK);
+
+   const std::string& path = fields[1];
+   struct stat st;
+   if( stat(path.c_str(), &st) != 0 )
+      memset(&st, 0, sizeof(st));
+   std::vector<Connection> waiting;
+   std::unordered_map<std::string, std::list<Holder>::iterator>::iterator itr = index.find(path);
+   std::list<Holder>::iterator holder = holders.end();
+   if( itr != index.end() )
+   {
+      holder = itr->second;
+      if( holder->mtime != (long long)st.st_mtime || holder->size != (long long)st.st_size )
+      {
+         /* the file changed: it is read again, also for the requests waiting for it */
+         waiting.swap(holder->waiting);
+         retire(holder);
+         holder = holders.end();
+      }
+      else
+         holders.splice(holders.begin(), holders, holder);
+   }
+   if( holder == holders.end() )
+      holder = startHolder(path, st);
+   if( holder == holders.end() )
+   {
+      /* the client checks on its own */
+      for( size_t i = 0; i < waiting.size(); ++i )
+         close(waiting[i].fd);
+      close(conn.fd);
+      return;
+   }
+   holder->waiting.insert(holder->waiting.end(), waiting.begin(), waiting.end());
+   if( !holder->ready )
+   {
+      holder->waiting.push_back(conn);
+      return;
+   }
+   if( !pass(*holder, conn) )
+   {
+      /* the holder is gone: start another */
+      retire(holder);
+      holder = startHolder(path, st);
+      if( holder == holders.end() )
+         close(conn.fd);
+      else
+         holder->waiting.push_back(conn);
+   }
+}
+
+bool CheckServer::pass(Holder& holder, Connection& conn)
+{
+   int64_t ticks = conn.arrival.time_since_epoch().count();
+   struct iovec iov[2];
+   iov[0].iov_base = &ticks;
+   iov[0].iov_len = sizeof(ticks);
+   iov[1].iov_base = (void*)conn.request.data();
+   iov[1].iov_len = conn.request.size();
+   char control[CMSG_SPACE(sizeof(int))];
+   memset(control, 0, sizeof(control));
+   struct msghdr msg;
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov = iov;
+   msg.msg_iovlen = 2;
+   msg.msg_control = control;
+   msg.msg_controllen = sizeof(control);
+   struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+   cmsg->cmsg_level = SOL_SOCKET;
+   cmsg->cmsg_type = SCM_RIGHTS;
+   cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+   memcpy(CMSG_DATA(cmsg), &conn.fd, sizeof(int));
+   ssize_t n;
+   do
+      n = sendmsg(holder.fd, &msg, 0);
+   while( n < 0 && errno == EINTR );
+   if( n < 0 )
+      return false;
+   close(conn.fd);
+   return true;
+}
+
+std::list<CheckServer::Holder>::iterator CheckServer::startHolder(const std::string& path, const struct stat& st)
+{
+   int sv[2];
+   if( socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0 )
+      return holders.end();
+   fflush(stdout);
+   pid_t pid = fork();
+   if( pid < 0 )
+   {
+      close(sv[0]);
+      close(sv[1]);
+      return holders.end();
+   }
+   if( pid == 0 )
+   {
+      /* the holder keeps only its own socket, so that the other holders see the dispatcher close theirs */
+      close(listenFd);
+      close(sv[0]);
+      for( std::list<Connection>::iterator conn = connections.begin(); conn != connections.end(); ++conn )
+         close(conn->fd);
+      for( std::list<Holder>::iterator holder = holders.begin(); holder != holders.end(); ++holder )
+      {
+         close(holder->fd);
+         for( size_t i = 0; i < holder->waiting.size(); ++i )
+            close(holder->waiting[i].fd);
+      }
+      hold(path, sv[1]);
+      _exit(0);
+   }
+   close(sv[1]);
+
+   Holder holder;
+   holder.path = path;
+   holder.mtime = st.st_mtime;
+   holder.size = st.st_size;
+   holder.memory = 0;
+   holder.ready = false;
+   holder.fd = sv[0];
+   holders.push_front(holder);
+   index[path] = holders.begin();
+   return holders.begin();
+}
+
+void CheckServer::holderReady(std::list<Holder>::iterator holder)
+{
+   HolderReport report;
+   ssize_t n;
+   do
+      n = read(holder->fd, &report, sizeof(report));
+   while( n < 0 && errno == EINTR );
+   if( n != (ssize_t)sizeof(report) )
+   {
+      /* gone while reading the model: its clients check on their own */
+      retire(holder);
+      return;
+   }
+   holder->ready = true;
+   std::vector<Connection> waiting;
+   waiting.swap(holder->waiting);
+   for( size_t i = 0; i < waiting.size(); ++i )
+   {
+      if( !pass(*holder, waiting[i]) )
+         close(waiting[i].fd);
+   }
+
+   /* a model that cannot be read or does not fit is not kept, once the requests for it are answered */
+   if( !report.ok || report.memory > memoryLimit )
+   {
+      retire(holder);
+      return;
+   }
+   holder->memory = report.memory;
+   memoryUsed += report.memory;
+   while( memoryUsed > memoryLimit )
+   {
+      std::list<Holder>::iterator victim = holders.end();
+      for( std::list<Holder>::iterator other = holders.begin(); other != holders.end(); ++other )
+      {
+         if( other != holder && other->ready )
+            victim = other;
+      }
+      if( victim == holders.end() )
+         break;
+      retire(victim);
+   }
+}
+
+void CheckServer::retire(std::list<Holder>::iterator holder)
+{
+   close(holder->fd);
+   for( size_t i = 0; i < holder->waiting.size(); ++i )
+      close(holder->waiting[i].fd);
+   if( holder->ready )
+      memoryUsed -= holder->memory;
+   std::unordered_map<std::string, std::list<Holder>::iterator>::iterator itr = index.find(holder->path);
+   if( itr != index.end() && itr->second == holder )
+      index.erase(itr);
+   holders.erase(holder);
+}
+
+void CheckServer::hold(const std::string& path, int fd)
+{
+   /* output of the reader goes to the log of the daemon */
+   HolderReport report;
+   size_t before = heapInUse();
+   Model* model = readModel(path.c_str());
+   size_t after = heapInUse();
+   report.ok = (model != NULL);
+   report.memory = (model == NULL ? 0 : after > before ? after - before : estimateMemory(model));
+   fflush(stdout);
+   if( write(fd, &report, sizeof(report)) != (ssize_t)sizeof(report) )
+      return;
+
+   /* answer the requests until the dispatcher closes the socket, each check in a child */
+   std::vector<char> buf(SERVER_MAXREQUEST);
+   while( true )
+   {
+      int64_t ticks;
+      struct iovec iov[2];
+      iov[0].iov_base = &ticks;
+      iov[0].iov_len = sizeof(ticks);
+      iov[1].iov_base = &buf[0];
+      iov[1].iov_len = buf.size();
+      char control[CMSG_SPACE(sizeof(int))];
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = 2;
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      ssize_t n = recvmsg(fd, &msg, 0);
+      if( n < 0 && errno == EINTR )
+         continue;
+      if( n <= (ssize_t)sizeof(ticks) )
+         break;
+      struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+      if( cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS )
+         continue;
+      int client;
+      memcpy(&client, CMSG_DATA(cmsg), sizeof(int));
+      std::string request(&buf[0], n - sizeof(ticks));
+      Clock::time_point arrival = Clock::time_point(Clock::duration(ticks));
+
+      fflush(stdout);
+      pid_t pid = fork();
+      if( pid == 0 )
+      {
+         close(fd);
+         answer(client, request, arrival, model);
+         _exit(0);
+      }
+      /* no child: check here */
+      if( pid < 0 )
+         answer(client, request, arrival, model);
+      close(client);
+   }
+}
+
+void CheckServer::answer(int client, const std::string& request, Clock::time_point arrival, Model* model)
+{
+   std::vector<std::string> fields;
+   parseRequest(request, fields);
+   bool profiling = (fields[5] == "profile");
+   Rational linearTolerance;
+   Rational intTolerance;
+   parseRational(fields[3].c_str(), linearTolerance);
+   parseRational(fields[4].c_str(), intTolerance);
+
+   fflush(stdout);
+   int savedFd = dup(STDOUT_FILENO);
+   dup2(client, STDOUT_FILENO);
+   /* the model is the holder's, so its memory is not of this check; the phase is the wait for it */
+   Profile profile;
+   profile.begin("parse", arrival);
+   profile.endCached();
+   check(model, fields[2].c_str(), linearTolerance, intTolerance, profiling ? &profile : NULL);
+   printf("%s\n", SERVER_END);
+   fflush(stdout);
+   dup2(savedFd, STDOUT_FILENO);
+   close(savedFd);
+}
+
+bool requestCheck(
+      const char* socketPath,
+      const char* mpsfile,
+      const char* solfile,
+      const Rational& linearTolerance,
+      const Rational& intTolerance,
+      bool profiling)
+{
+   struct sockaddr_un addr;
+   if( !socketAddress(socketPath, addr) )
+      return false;
+   int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if( fd < 0 )
+      return false;
+   if( connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 )
+   {
+      close(fd);
+      return false;
+   }
+
+   /* the daemon runs in another directory */
+   char mpspath[PATH_MAX];
+   char solpath[PATH_MAX];
+   if( realpath(mpsfile, mpspath) == NULL )
+      strncpy(mpspath, mpsfile, PATH_MAX - 1)[PATH_MAX - 1] = '\0';
+   if( realpath(solfile, solpath) == NULL )
+      strncpy(solpath, solfile, PATH_MAX - 1)[PATH_MAX - 1] = '\0';
+   std::string request = std::string(SERVER_MAGIC) + "\n" + mpspath + "\n" + solpath + "\n"
+      + linearTolerance.toString() + "\n" + intTolerance.toString() + "\n" + (profiling ? "profile" : "") + "\n";
+   signal(SIGPIPE, SIG_IGN);
+   if( !writeAll(fd, request.data(), request.size()) )
+   {
+      close(fd);
+      return false;
+   }
+
+   /* copy the report once it is complete */
+   std::string report;
+   char buf[4096];
+   while( true )
+   {
+      ssize_t n = read(fd, buf, sizeof(buf));
+      if( n < 0 && errno == EINTR )
+         continue;
+      if( n <= 0 )
+         break;
+      report.append(buf, n);
+   }
+   close(fd);
+   std::string end = std::string(SERVER_END) + "\n";
+   if( report.size() < end.size() || report.compare(report.size() - end.size(), end.size(), end) != 0 )
+      return false;
+   fflush(stdout);
+   writeAll(STDOUT_FILENO, report.data(), report.size() - end.size());
+   return true;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file server.h
+ * @brief Checker daemon keeping parsed models in memory, and its client
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "model.h"
+#include "profile.h"
+#include <stddef.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Checker daemon answering check requests on a UNIX domain socket.
+ * Parsed models are kept in memory, bounded by a memory limit, so that the checks of all jobs
+ * on a node that hit the same instance parse it only once.
+ * The daemon is a single-threaded dispatcher: it reads the requests of all clients without
+ * blocking, dropping those not complete within SERVER_TIMEOUT seconds, and hands every complete
+ * request, with its connection, to the holder of the model. A holder is a process forked by the
+ * dispatcher for one MPS file: it reads the model once, and then forks a child for each check,
+ * which writes the report straight to the client. Requests for a model still being read wait
+ * in the dispatcher until the holder has it. Holders are stopped least recently used first
+ * when their models exceed the memory limit, after answering the requests handed to them.
+ * Processes only fork while single-threaded, and no parse runs in the dispatcher, so neither a
+ * parse nor a stalled client holds up the other requests.
+ *
+ * A request is a block of lines: "SOLCHECKER 2", the MPS file, the solution file, the linear
+ * and the integrality tolerance (as exact fractions), and the options ("profile" or nothing). The response is the report, as printed
+ * by the checker when run on its own, followed by the line SERVER_END, and ends when the connection is closed.
+ */
+class CheckServer
+{
+   public:
+      /** reads the model of an MPS file (NULL if it cannot be read) */
+      typedef std::function<Model*(const char* mpsfile)> ReadFunc;
+      /** prints the report of checking a solution file against a model (NULL if it could not be read),
+       * with the profile (if not NULL) that holds the time of getting the model */
+      typedef std::function<void(Model* model, const char* solfile, const Rational& linearTolerance, const Rational& intTolerance, Profile* profile)> CheckFunc;
+
+      /**
+       * Constructor
+       * @param _socketPath path of the socket to listen on
+       * @param _memoryLimit bound on the memory of the cached models, in bytes
+       * @param _idleTimeout seconds without requests after which the daemon stops (0 for never)
+       * @param _readModel function reading models
+       * @param _check function checking solutions
+       */
+      CheckServer(const char* _socketPath, size_t _memoryLimit, int _idleTimeout, ReadFunc _readModel, CheckFunc _check);
+
+      /** Destructor, stops the holders */
+      ~CheckServer();
+
+      /**
+       * Answer requests until the daemon is idle for too long.
+       * @return false if the socket cannot be set up, e.g. because another daemon serves it
+       */
+      bool run();
+
+   protected:
+      /* connection of a client, with its request */
+      struct Connection
+      {
+         int fd;
+         std::string request;
+         /* time the connection was accepted */
+         std::chrono::steady_clock::time_point arrival;
+      };
+
+      /* process holding the model of an MPS file (see the class comment) */
+      struct Holder
+      {
+         /* path of the MPS file */
+         std::string path;
+         /* modification time of the MPS file when it was read */
+         long long mtime;
+         /* size of the MPS file when it was read */
+         long long size;
+         /* memory used by the model, in bytes (known once ready) */
+         size_t memory;
+         /* has the holder read the model? */
+         bool ready;
+         /* dispatcher end of the socket to the holder */
+         int fd;
+         /* connections waiting for the model to be read */
+         std::vector<Connection> waiting;
+      };
+
+      /* path of the socket */
+      std::string socketPath;
+      /* bound on the memory of the cached models, in bytes */
+      size_t memoryLimit;
+      /* seconds without requests after which the daemon stops (0 for never) */
+      int idleTimeout;
+      ReadFunc readModel;
+      CheckFunc check;
+      /* socket listening for requests */
+      int listenFd;
+      /* connections whose request is not complete yet */
+      std::list<Connection> connections;
+      /* holders, most recently used first */
+      std::list<Holder> holders;
+      /* path -> position in holders */
+      std::unordered_map<std::string, std::list<Holder>::iterator> index;
+      /* memory used by the models of the ready holders, in bytes */
+      size_t memoryUsed;
+
+      /**
+       * Read what the client of @param conn has sent.
+       * @return false if the connection is to be dropped (closed, or request too long)
+       */
+      bool receive(Connection& conn);
+
+      /** Hand the complete request of @param conn to the holder of its model, starting one if needed */
+      void dispatch(Connection& conn);
+
+      /** Pass @param conn to @param holder; false if the holder is gone */
+      bool pass(Holder& holder, Connection& conn);
+
+      /** Fork a holder for the MPS file @param path with status @param st (zero if missing) */
+      std::list<Holder>::iterator startHolder(const std::string& path, const struct stat& st);
+
+      /** Take the report of a holder that has read its model */
+      void holderReady(std::list<Holder>::iterator holder);
+
+      /** Stop a holder: it exits once it has answered the requests passed to it */
+      void retire(std::list<Holder>::iterator holder);
+
+      /** Process of a holder: read the model of @param path, then answer the requests coming on @param fd */
+      void hold(const std::string& path, int fd);
+
+      /** Check the solution of @param request (accepted at @param arrival) against @param model, writing the report to @param client */
+      void answer(int client, const std::string& request, std::chrono::steady_clock::time_point arrival, Model* model);
+};
+
+/**
+ * Send a check request to a running CheckServer and copy the report to stdout.
+ * The report is only copied once complete, i.e. ending with the line SERVER_END; a report cut
+ * short (e.g. because the daemon was killed) counts as no answer.
+ * @param socketPath path of the socket of the daemon
+ * @param profiling should the report end with the profile of the check (see Profile)?
+ * @return false if no daemon answered in full (nothing was printed then)
+ */
+bool requestCheck(
+      const char* socketPath,
+      const char* mpsfile,
+      const char* solfile,
+      const Rational& linearTolerance,
+      const Rational& intTolerance,
+      bool profiling);
+
+#endif
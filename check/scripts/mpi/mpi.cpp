@@ -7,28 +7,44 @@
 #include <mpi.h>
 #include <cstring>
 #include <vector>
+#include <deque>
 #include <unordered_map>
 #include <ctime>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 using namespace std;
 
-#define MAX_LINE           1000
 #define MAX_HOST_NAME      16
 
+/* message tags */
+#define TAG_HOST           1
+#define TAG_ACTIVE         2
+#define TAG_REPORT         3
+#define TAG_JOBS           4
+
 typedef struct
 {
    int myid;
    char name[MAX_HOST_NAME];
 }HostInfo;
 
-/* check whether host i has enough thread to run a new job */
-bool CheckThreads(vector<int>& numthreads, int i, int workthread, int totalthread)
+/* job of the tasks file */
+typedef struct
 {
-   if( numthreads[i] + workthread <= totalthread )
-      return true;
-   else
-      return false;
-}
+   int idx;
+   string command;
+}Job;
+
+/* end of a job, reported to the master */
+typedef struct
+{
+   int idx;
+   int status;
+   double runtime;
+}JobResult;
 
 static string getInsName(string command)
 {
@@ -46,6 +62,229 @@ static string getInsName(string command)
    return name;
 }
 
+/**
+ * runs the jobs of a host on a fixed number of slots, each job using the cores of one slot;
+ * every slot has a deque of jobs, new jobs are dealt to the deques round robin, and a slot runs
+ * the jobs at the front of its own deque and steals from the back of the others when it is empty,
+ * so that a slot whose job ends early takes over the waiting jobs of the busy slots
+ */
+class Executor
+{
+public:
+   /* start @param nslots slots */
+   Executor(int nslots);
+   /* wait for the queued jobs to end and stop the slots */
+   ~Executor();
+   /* add jobs to the deques */
+   void push(const vector<Job>& jobs);
+   /* number of jobs not started yet */
+   int numQueued();
+   /* number of jobs not ended yet */
+   int numPending();
+   /* move the results of the ended jobs to @param results, waiting for one if @param wait is true and a job is pending */
+   void collect(vector<JobResult>& results, bool wait);
+
+private:
+   struct Slot
+   {
+      mutex lock;
+      deque<Job> jobs;
+   };
+   vector<Slot> slots;
+   vector<thread> threads;
+   /* guards the members below */
+   mutex lock;
+   /* signals new jobs to the slots */
+   condition_variable wakeup;
+   /* signals ended jobs to collect() */
+   condition_variable ended;
+   int queued;
+   int running;
+   bool closing;
+   vector<JobResult> results;
+   /* slot getting the next pushed job */
+   int next;
+
+   bool take(int slot, Job& job);
+   void run(int slot);
+};
+
+Executor::Executor(int nslots)
+   : slots(nslots), queued(0), running(0), closing(false), next(0)
+{
+   for( int i = 0; i < nslots; i++ )
+      threads.push_back(thread(&Executor::run, this, i));
+}
+
+Executor::~Executor()
+{
+   {
+      lock_guard<mutex> guard(lock);
+      closing = true;
+   }
+   wakeup.notify_all();
+   for( size_t i = 0; i < threads.size(); i++ )
+      threads[i].join();
+}
+
+void Executor::push(const vector<Job>& jobs)
+{
+   if( jobs.empty() )
+      return;
+   for( size_t i = 0; i < jobs.size(); i++ )
+   {
+      lock_guard<mutex> guard(slots[next].lock);
+      slots[next].jobs.push_back(jobs[i]);
+      next = (next + 1) % slots.size();
+   }
+   {
+      lock_guard<mutex> guard(lock);
+      queued += jobs.size();
+   }
+   wakeup.notify_all();
+}
+
+int Executor::numQueued()
+{
+   lock_guard<mutex> guard(lock);
+   return queued;
+}
+
+int Executor::numPending()
+{
+   lock_guard<mutex> guard(lock);
+   return queued + running;
+}
+
+void Executor::collect(vector<JobResult>& out, bool wait)
+{
+   unique_lock<mutex> guard(lock);
+   if( wait )
+      ended.wait(guard, [this]{ return !results.empty() || queued + running == 0; });
+   out.insert(out.end(), results.begin(), results.end());
+   results.clear();
+}
+
+/* take the next job of @param slot: from the front of its deque, or else from the back of another deque */
+bool Executor::take(int slot, Job& job)
+{
+   int nslots = slots.size();
+   for( int k = 0; k < nslots; k++ )
+   {
+      Slot& victim = slots[(slot + k) % nslots];
+      lock_guard<mutex> guard(victim.lock);
+      if( victim.jobs.empty() )
+         continue;
+      if( k == 0 )
+      {
+         job = victim.jobs.front();
+         victim.jobs.pop_front();
+      }
+      else
+      {
+         job = victim.jobs.back();
+         victim.jobs.pop_back();
+      }
+      lock_guard<mutex> guard2(lock);
+      queued--;
+      running++;
+      return true;
+   }
+   return false;
+}
+
+void Executor::run(int slot)
+{
+   Job job;
+   while( true )
+   {
+      if( !take(slot, job) )
+      {
+         unique_lock<mutex> guard(lock);
+         if( queued == 0 && closing )
+            return;
+         wakeup.wait(guard, [this]{ return queued > 0 || closing; });
+         continue;
+      }
+      /* execute the command */
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      JobResult result;
+      result.idx = job.idx;
+      result.status = system(job.command.c_str());
+      result.runtime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+      if( result.status != 0 )
+         printf("job %d error! instance name: %s\n", job.idx, getInsName(job.command).c_str());
+      {
+         lock_guard<mutex> guard(lock);
+         running--;
+         results.push_back(result);
+      }
+      ended.notify_all();
+   }
+}
+
+/* read up to @param n jobs from the tasks file, @param exhausted tells whether the file has ended */
+static void readJobs(ifstream& file, int n, vector<Job>& jobs, vector<string>& cmdOrder, bool& exhausted)
+{
+   string command;
+   jobs.clear();
+   while( (int)jobs.size() < n && !exhausted )
+   {
+      if( !getline(file, command) )
+      {
+         exhausted = true;
+         break;
+      }
+      Job job;
+      job.idx = cmdOrder.size();
+      job.command = command;
+      jobs.push_back(job);
+      cmdOrder.push_back(command);
+   }
+}
+
+/* send a report of the ended jobs of a worker to the master: the number of jobs wanted
+ * (negative when the worker is done) followed by index, status and run time of each job */
+static void sendReport(int nwanted, vector<JobResult>& results)
+{
+   vector<double> report;
+   report.push_back(nwanted);
+   for( size_t i = 0; i < results.size(); i++ )
+   {
+      report.push_back(results[i].idx);
+      report.push_back(results[i].status);
+      report.push_back(results[i].runtime);
+   }
+   MPI_Send(&report[0], report.size(), MPI_DOUBLE, 0, TAG_REPORT, MPI_COMM_WORLD);
+   results.clear();
+}
+
+/* send a batch of jobs to a worker as lines "index command", no jobs meaning that the tasks file has ended */
+static void sendJobs(const vector<Job>& jobs, int target)
+{
+   string batch;
+   for( size_t i = 0; i < jobs.size(); i++ )
+      batch += to_string(jobs[i].idx) + " " + jobs[i].command + "\n";
+   /* batch.size() needs plus 1, because the function size() does not count \0 */
+   MPI_Send(batch.c_str(), batch.size()+1, MPI_CHAR, target, TAG_JOBS, MPI_COMM_WORLD);
+}
+
+/* receive a batch of jobs from the master */
+static void recvJobs(vector<Job>& jobs)
+{
+   MPI_Status status;
+   int count;
+   MPI_Probe(0, TAG_JOBS, MPI_COMM_WORLD, &status);
+   MPI_Get_count(&status, MPI_CHAR, &count);
+   vector<char> batch(count);
+   MPI_Recv(&batch[0], count, MPI_CHAR, 0, TAG_JOBS, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+   jobs.clear();
+   stringstream str(&batch[0]);
+   Job job;
+   while( str >> job.idx && getline(str.ignore(1), job.command) )
+      jobs.push_back(job);
+}
+
 int main(int argc,char *argv[])
 {
    /* number of threads per host */
@@ -68,17 +307,18 @@ int main(int argc,char *argv[])
    }
    int myid;
    int numprocs;
-   MPI_Init(&argc, &argv);
+   int provided;
+   /* only the main thread of a process makes MPI calls, the slots of the executor do not */
+   MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+   if( provided < MPI_THREAD_FUNNELED )
+   {
+      printf("Error! the MPI library does not support threads (MPI_THREAD_FUNNELED)\n");
+      MPI_Abort(MPI_COMM_WORLD, -1);
+   }
    /* get the current process index */
    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
    /* get the number of processes */
    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
-   /* check thread number */
-   if( numprocs <= 1 )
-   {
-      printf("only one thread is available!");
-      return 0;
-   }
    /* make new data type in mpi to collect the host information */
    HostInfo hostinfo;
    MPI_Datatype Type_HostInfo;
@@ -103,8 +343,9 @@ int main(int argc,char *argv[])
    /* get host information */
    hostinfo.myid = myid;
    gethostname(hostinfo.name, MAX_HOST_NAME);
+   hostinfo.name[MAX_HOST_NAME-1] = '\0';
 
-   /* master thread */
+   /* master process: hands out the jobs and runs some on its own host */
    if( myid == 0 )
    {
       string filename = argv[1];
@@ -113,148 +354,165 @@ int main(int argc,char *argv[])
       if( !file.is_open() )
       {
          printf("Error! cannot open file %s\n", filename.c_str());
-         exit(-1);
+         MPI_Abort(MPI_COMM_WORLD, -1);
       }
-      /* number of threads working at the same time */
-      int nworker = numprocs-1;
+      /* one process per host is used, further processes on a host are turned off */
+      int nworker = 0;
       unordered_map<string, int> map;
-      unordered_map<string, int>::iterator iter;
-      vector<int> thread2host(numprocs);
-      /* host name list */
-      vector<string> hostnames;
-      /* number of working threads per host */
-      vector<int> numthreads;
+      vector<int> isuse(numprocs, -1);
       map[hostinfo.name] = 0;
-      thread2host[myid] = 0;
-      hostnames.push_back(hostinfo.name);
-      /* master use 1 thread */
-      numthreads.push_back(1);
       /* collect host information from workers */
       for( int i = 1; i < numprocs; i++ )
       {
-         MPI_Recv(&hostinfo, 1, Type_HostInfo, MPI_ANY_SOURCE, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-         iter = map.find(hostinfo.name);
-         if( iter == map.end() )
-         {
-            map[hostinfo.name] = hostnames.size();
-            thread2host[hostinfo.myid] = hostnames.size();
-            hostnames.push_back(hostinfo.name);
-            /* add load to the host */
-            numthreads.push_back(workthread);
-         }
-         else
+         MPI_Recv(&hostinfo, 1, Type_HostInfo, MPI_ANY_SOURCE, TAG_HOST, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+         if( map.find(hostinfo.name) == map.end() )
          {
-            thread2host[hostinfo.myid] = iter->second;
-            //TODO check number of threads
-            if( CheckThreads(numthreads, iter->second, workthread, totalthread) )
-               numthreads[iter->second] += workthread;
-            else
-            {
-               thread2host[hostinfo.myid] = -1;
-               nworker -= 1;
-            }
+            map[hostinfo.name] = hostinfo.myid;
+            isuse[hostinfo.myid] = 1;
+            nworker++;
          }
       }
-      printf("--- Host Statistic --- %d hosts, %d threads, %d wokers, %d workthread, %d totalthread.\n", int(hostnames.size()), numprocs, nworker, workthread, totalthread);
-      /* turn the worker threads on or off depend on the value of thread2host */
+      /* master uses 1 thread of its host for dispatching, unless it is the only host: then it only
+       * feeds its own executor, which costs next to nothing */
+      int nslots = (nworker > 0 ? (totalthread - 1) / workthread : totalthread / workthread);
+      printf("--- Host Statistic --- %d hosts, %d processes, %d jobs per host, %d jobs on master host, %d workthread, %d totalthread.\n",
+         nworker + 1, numprocs, totalthread / workthread, nslots, workthread, totalthread);
+      /* turn the worker processes on or off */
       for( int i = 1; i < numprocs; i++ )
-         MPI_Send(&thread2host[i], 1, MPI_INT, i, 2, MPI_COMM_WORLD);
+         MPI_Send(&isuse[i], 1, MPI_INT, i, TAG_ACTIVE, MPI_COMM_WORLD);
 
-      /* target process index */
-      int target;
-      /* inline command in task file */
-      string command;
-      /* start time of each job */
-      vector<double> startTime;
       /* run time of each job */
       vector<double> runTime;
-      /* thread accepts the task order */
+      /* process that runs each job */
       vector<int> threadOrder;
-      /* command execution order */
+      /* command of each job */
       vector<string> cmdOrder;
-      /* current job of each worker, -1 means no job */
-      vector<int> currentJobIdx(numprocs, -1);
-      /* work(command) index */
-      int workIdx = 0;
-      /* master assigns tasks to workers */
+      vector<Job> jobs;
+      vector<JobResult> results;
+      vector<double> report;
+      bool exhausted = false;
+      Executor executor(nslots);
       cout<<endl<<"============================== MPI START =============================="<<endl<<endl;
-      while( getline(file, command) )
+      /* serve the workers and the executor of the master host until all jobs have ended */
+      while( true )
       {
-         /* process target is ready to execute the command */
-         MPI_Recv(&target, 1, MPI_INT, MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-         /* if the previous work completed, record the run time */
-         if( currentJobIdx[target] >= 0 )
+         /* results of the jobs ending from now on are collected below, before the loop is left */
+         bool done = (nworker == 0 && exhausted && executor.numPending() == 0);
+         bool progress = false;
+         /* keep a batch of jobs queued on the master host */
+         if( !exhausted && nslots > 0 && executor.numQueued() < nslots )
          {
-            runTime[currentJobIdx[target]] = MPI_Wtime() - startTime[currentJobIdx[target]];
-            cout<<"---END--- "<<getInsName(cmdOrder[currentJobIdx[target]])<<endl;
+            readJobs(file, 2 * nslots - executor.numPending(), jobs, cmdOrder, exhausted);
+            for( size_t i = 0; i < jobs.size(); i++ )
+            {
+               runTime.push_back(0);
+               threadOrder.push_back(0);
+               cout<<"---SUBMIT--- "<<getInsName(jobs[i].command)<<endl;
+            }
+            executor.push(jobs);
+            progress = true;
          }
-         currentJobIdx[target] = workIdx;
-         startTime.push_back(MPI_Wtime());
-         runTime.push_back(0);
-         threadOrder.push_back(target);
-         cmdOrder.push_back(command);
-         /* command.size() needs plus 1, because the function size() does not count \0 */
-         MPI_Send(command.c_str(), command.size()+1, MPI_CHAR, target, 0, MPI_COMM_WORLD);
-         cout<<"---SUBMIT--- "<<getInsName(command)<<endl;
-         workIdx++;
-      }
-      /* get the current system time */
-      time_t now = std::time(nullptr);
-      /* convert to a string and output */
-      cout<<endl<<"Submit Over, Current Time: "<<asctime(localtime(&now));
-      cout<<endl<<"========== exit =========="<<endl<<endl;
-      /* stop running with a number of nworker */
-      for( int i = 0; i < nworker; i++ )
-      {
-         /* turn on worker threads */
-         char none[5] = "none";
-         //if( thread2host[i] >= 0 )
+         results.clear();
+         executor.collect(results, false);
+         for( size_t i = 0; i < results.size(); i++ )
          {
-            MPI_Recv(&target, 1, MPI_INT, MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            MPI_Send(none, 5, MPI_CHAR, target, 0, MPI_COMM_WORLD);
-            cout<<"thread "<<target<<" ends"<<endl;
+            runTime[results[i].idx] = results[i].runtime;
+            cout<<"---END--- "<<getInsName(cmdOrder[results[i].idx])<<endl;
          }
-         if( currentJobIdx[target] >= 0 )
+         progress = progress || !results.empty();
+
+         /* process a report of a worker and send it the jobs it wants */
+         int flag;
+         MPI_Status status;
+         MPI_Iprobe(MPI_ANY_SOURCE, TAG_REPORT, MPI_COMM_WORLD, &flag, &status);
+         if( flag )
          {
-            runTime[currentJobIdx[target]] = MPI_Wtime() - startTime[currentJobIdx[target]];
-            cout<<"---END--- "<<getInsName(cmdOrder[currentJobIdx[target]])<<endl;
+            int count;
+            MPI_Get_count(&status, MPI_DOUBLE, &count);
+            report.resize(count);
+            MPI_Recv(&report[0], count, MPI_DOUBLE, status.MPI_SOURCE, TAG_REPORT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            for( int k = 1; k + 2 < count; k += 3 )
+            {
+               int idx = (int)report[k];
+               runTime[idx] = report[k+2];
+               cout<<"---END--- "<<getInsName(cmdOrder[idx])<<endl;
+            }
+            int nwanted = (int)report[0];
+            if( nwanted > 0 )
+            {
+               readJobs(file, nwanted, jobs, cmdOrder, exhausted);
+               for( size_t i = 0; i < jobs.size(); i++ )
+               {
+                  runTime.push_back(0);
+                  threadOrder.push_back(status.MPI_SOURCE);
+                  cout<<"---SUBMIT--- "<<getInsName(jobs[i].command)<<endl;
+               }
+               sendJobs(jobs, status.MPI_SOURCE);
+            }
+            else if( nwanted < 0 )
+            {
+               cout<<"process "<<status.MPI_SOURCE<<" ends"<<endl;
+               nworker--;
+            }
+            progress = true;
          }
+         if( done )
+            break;
+         /* nothing to do: wait a moment for jobs to end */
+         if( !progress )
+            usleep(1000);
       }
+      /* get the current system time */
+      time_t now = std::time(nullptr);
+      /* convert to a string and output */
+      cout<<endl<<"Submit Over, Current Time: "<<asctime(localtime(&now));
       cout<<endl<<"========== over =========="<<endl<<endl;
-      for( int i = 0; i < workIdx; i++ )
+      for( size_t i = 0; i < cmdOrder.size(); i++ )
       {
-         printf("job %4d \t costs %5.1f \t seconds in thread %4d \t  run %s\n", i, runTime[i], threadOrder[i], getInsName(cmdOrder[i]).c_str());
+         printf("job %4d \t costs %5.1f \t seconds in process %4d \t  run %s\n", int(i), runTime[i], threadOrder[i], getInsName(cmdOrder[i]).c_str());
       }
       file.close();
       cout<<endl<<"==============================  MPI END  =============================="<<endl<<endl;
    }
-   /* worker thread */
+   /* worker process: runs the jobs of its host */
    else
    {
       /* send the host information to master */
       int isuse;
-      MPI_Send(&hostinfo, 1, Type_HostInfo, 0, 1, MPI_COMM_WORLD);
-      MPI_Recv(&isuse, 1, MPI_INT, 0, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      MPI_Send(&hostinfo, 1, Type_HostInfo, 0, TAG_HOST, MPI_COMM_WORLD);
+      MPI_Recv(&isuse, 1, MPI_INT, 0, TAG_ACTIVE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
-      /* receive command from master */
-      char command[MAX_LINE];
-      int status;
-      /* keep running until receive a stop signal from the master */
-      while( isuse >= 0 )
+      if( isuse >= 0 )
       {
-         /* waiting task */
-         MPI_Send(&myid, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
-         /* workers receives tasks froms master */
-         MPI_Recv(command, MAX_LINE, MPI_CHAR, MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-         if( strcmp(command, "none") == 0 )
+         int nslots = totalthread / workthread;
+         Executor executor(nslots);
+         vector<Job> jobs;
+         vector<JobResult> results;
+         bool exhausted = false;
+         /* keep up to one batch of jobs queued besides the running ones, so that a slot
+          * whose job ends can start the next one without waiting for the master */
+         while( true )
          {
-            break;
-         }
-         /* execute the command */
-         status = system(command);
-         if( status != 0 )
-         {
-            printf("work %d error! instance name: %s\n", myid, getInsName(command).c_str());
+            executor.collect(results, false);
+            if( exhausted && executor.numPending() == 0 )
+            {
+               executor.collect(results, false);
+               sendReport(-1, results);
+               break;
+            }
+            if( !exhausted && executor.numQueued() < nslots )
+            {
+               sendReport(2 * nslots - executor.numPending(), results);
+               recvJobs(jobs);
+               if( jobs.empty() )
+                  exhausted = true;
+               executor.push(jobs);
+               continue;
+            }
+            /* report the ended jobs right away */
+            if( !results.empty() )
+               sendReport(0, results);
+            executor.collect(results, true);
          }
       }
    }
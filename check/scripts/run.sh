@@ -241,10 +241,12 @@ if [[ ${MPI} == on ]]
 then
    if [[ ${CLUSTER} == on ]]
    then
+      # mpiexecline keeps one process per host, each running up to HC/JC jobs at the same time,
+      # and turns the other processes of a host off
       bsub -J ${TSTNAME} -q ${QUEUE} -R "span[ptile=${HC}]" -n ${TC} -e %J.err -o %J.out "mpirun ./scripts/mpi/mpiexecline ./${OUTDIR}/${TSTNAME}.history ${HC} ${JC}"
    else
-      # count computer cores
-      mpirun -n $(cat /proc/cpuinfo|grep "cpu cores"|uniq | awk '{print $4}') ./scripts/mpi/mpiexecline ./${OUTDIR}/${TSTNAME}.history ${HC} ${JC}
+      # a single process runs the jobs on the cores of this computer
+      mpirun -n 1 ./scripts/mpi/mpiexecline ./${OUTDIR}/${TSTNAME}.history ${HC} ${JC}
    fi
 fi
 
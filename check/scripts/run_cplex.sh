@@ -40,7 +40,7 @@ else
    # solve problem
    echo optimize                                         >> ${CMDFILE}
    #TODO if time limit, cplex can not write sol
-   # write solution
+   # write solution (the solution checker reads the CPLEX XML format as it is)
    echo write ${SOLFILE}                                 >> ${CMDFILE}
 fi
 # exit interactive interface
@@ -59,18 +59,6 @@ then
    rm -rf ${SOLFILE}.pre
    # compress presolved problem
    gzip ${TRAFILE}
-else
-   if test -e ${SOLFILE}
-   then
-      # translate CPLEX solution format into format for solution checker.
-      # The SOLFILE format is a very simple format where in each line
-      # we have a <variable, value> pair, separated by spaces.
-      # A variable name of =obj= is used to store the objective value
-      # of the solution, as computed by the solver. A variable name of
-      # =infeas= can be used to indicate that an instance is infeasible.
-      $(dirname "${BASH_SOURCE[0]}")/cpx2solchecker.py ${SOLFILE} > ${CMDFILE}tempsol
-      mv ${CMDFILE}tempsol ${SOLFILE}
-   fi
 fi
 
 # remove CPLEX log
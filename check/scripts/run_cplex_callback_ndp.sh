@@ -18,15 +18,3 @@ if [[ ${retcode} != "0" ]]
 then
    exit ${retcode};
 fi
-
-if test -e ${SOLFILE}
-then
-   # translate CPLEX solution format into format for solution checker.
-   # The SOLFILE format is a very simple format where in each line
-   # we have a <variable, value> pair, separated by spaces.
-   # A variable name of =obj= is used to store the objective value
-   # of the solution, as computed by the solver. A variable name of
-   # =infeas= can be used to indicate that an instance is infeasible.
-   $(dirname "${BASH_SOURCE[0]}")/cpx2solchecker.py ${SOLFILE} > ${CMDFILE}tempsol
-   mv ${CMDFILE}tempsol ${SOLFILE}
-fi
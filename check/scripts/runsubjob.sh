@@ -43,9 +43,17 @@ then
       then
          if [[ -e ${CHECKPATH}/checker/bin/solchecker ]]
          then
+            # with SOLCHECKER_SOCKET set, the checks of all jobs on this node go to one daemon
+            # keeping the parsed instances; the checker falls back to checking itself without it,
+            # or when the daemon's report is cut short.
+            # The daemon must be started outside the lifetime of the jobs (a job's processes are
+            # killed when it ends, which would cut the checks of the other jobs), e.g. once per
+            # node before the jobs are submitted, with a cache bound and an idle timeout:
+            #    solchecker -m <megabytes> --idle <seconds> --serve ${SOLCHECKER_SOCKET}
             echo ""
             echo "Solution Check"
-            ${CHECKPATH}/checker/bin/solchecker ${INSFILE} ${SOLFILE} ${LINTOL} ${INTTOL}
+            # the last line of the check is its profile as JSON (time and peak memory per phase)
+            ${CHECKPATH}/checker/bin/solchecker --profile ${INSFILE} ${SOLFILE} ${LINTOL} ${INTTOL}
             retcode=$?
             if [[ ${retcode} != "0" ]]
             then